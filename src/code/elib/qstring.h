@@ -167,6 +167,12 @@ public:
       size_t operator ()(const qstring &qstr) const { return qstr.hashCode(); }
    };
 
+   // key equality for case-insensitive maps; pairs with hash
+   struct caseequal
+   {
+      bool operator ()(const qstring &a, const qstring &b) const { return !a.strCaseCmp(b.constPtr()); }
+   };
+
    // Copying and Swapping
    qstring &copy(const char *str);
    qstring &copy(const char *str, size_t count);
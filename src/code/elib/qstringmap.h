@@ -30,13 +30,14 @@
 #include <unordered_map>
 #include "qstring.h"
 
-template<typename T, typename C>
+// Pass qstring::caseequal as E for a case-insensitive map
+template<typename T, typename C, typename E = std::equal_to<qstring>>
 class qstringmap
 {
 public:
    C m_hashkeyfunc;
 
-   using TMap = std::unordered_map<qstring, T, qstring::hash>;
+   using TMap = std::unordered_map<qstring, T, qstring::hash, E>;
    TMap tmap;
 
    qstringmap(C hashkeyfunc) : m_hashkeyfunc(hashkeyfunc), tmap() {}
@@ -46,6 +47,11 @@ public:
       tmap.emplace(qstring(m_hashkeyfunc(obj)), obj);
    }
 
+   void erase(T obj)
+   {
+      tmap.erase(qstring(m_hashkeyfunc(obj)));
+   }
+
    bool contains(T obj) const
    {
       return tmap.find(qstring(m_hashkeyfunc(obj))) != tmap.cend();
@@ -58,7 +64,7 @@ public:
 
    T find(const char *name) const
    {
-      TMap::const_iterator itr = tmap.find(qstring(name));
+      typename TMap::const_iterator itr = tmap.find(qstring(name));
       return (itr != tmap.cend()) ? itr->second : nullptr;
    }
 
@@ -1141,7 +1141,7 @@ qboolean Actor::HasEnemies(void)
 
 qboolean Actor::IsEnemy(Entity *ent)
 {
-   return enemyList.ObjectInList(EntityPtr(ent)) && seenEnemy;
+   return enemyList.ObjectInList(EntityHandle(ent)) && seenEnemy;
 }
 
 void Actor::MakeEnemy(Entity *ent, qboolean force)
@@ -1153,9 +1153,9 @@ void Actor::MakeEnemy(Entity *ent, qboolean force)
       !(ent->flags & FL_NOTARGET) &&
       (ent->takedamage != DAMAGE_NO))
    {
-      if(!enemyList.ObjectInList(EntityPtr(ent)))
+      if(!enemyList.ObjectInList(EntityHandle(ent)))
       {
-         enemyList.AddObject(EntityPtr(ent));
+         enemyList.AddObject(EntityHandle(ent));
       }
 
       if(!currentEnemy && !seenEnemy)
@@ -1294,10 +1294,10 @@ qboolean Actor::GetVisibleTargets(void)
       {
          if(WithinDistance(ent, vision_distance) && CanSeeFOV(ent))
          {
-            targetList.AddObject(EntityPtr(ent));
+            targetList.AddObject(EntityHandle(ent));
             if(WithinDistance(ent, 96))
             {
-               nearbyList.AddObject(EntityPtr(ent));
+               nearbyList.AddObject(EntityHandle(ent));
             }
             MakeEnemy(ent);
          }
@@ -1309,10 +1309,10 @@ qboolean Actor::GetVisibleTargets(void)
          {
             if(WithinDistance(ent, vision_distance) && CanSeeFOV(ent))
             {
-               targetList.AddObject(EntityPtr(ent));
+               targetList.AddObject(EntityHandle(ent));
                if(WithinDistance(ent, 96))
                {
-                  nearbyList.AddObject(EntityPtr(ent));
+                  nearbyList.AddObject(EntityHandle(ent));
                }
                MakeEnemy(act->currentEnemy);
                if(act->deadflag)
@@ -2912,7 +2912,7 @@ void Actor::IfNearEvent(Event *ev)
       bestent = NULL;
       bestdist = distance * distance;
 
-      tlist = world->GetTargetList(str(&name[1]));
+      tlist = world->GetTargetList(&name[1]);
       n = tlist->list.NumObjects();
       for(i = 1; i <= n; i++)
       {
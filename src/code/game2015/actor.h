@@ -225,7 +225,7 @@ inline EXPORT_FROM_DLL void ActorState::Unarchive(Archiver &arc)
 // Exported templated classes must be explicitly instantiated
 //
 #ifdef EXPORT_TEMPLATE
-template class EXPORT_FROM_DLL Container<EntityPtr>;
+template class EXPORT_FROM_DLL Container<EntityHandle>;
 template class EXPORT_FROM_DLL Stack<ActorState *>;
 #endif
 
@@ -261,9 +261,9 @@ public:
 
    PathPtr                    path;
 
-   Container<EntityPtr>       targetList;
-   Container<EntityPtr>       nearbyList;
-   Container<EntityPtr>       enemyList;
+   Container<EntityHandle>    targetList;
+   Container<EntityHandle>    nearbyList;
+   Container<EntityHandle>    enemyList;
    EntityPtr                  currentEnemy;
    qboolean                   seenEnemy;
    range_t                    enemyRange;
@@ -738,7 +738,7 @@ inline EXPORT_FROM_DLL void Actor::Unarchive(Archiver &arc)
    targetList.Resize(num);
    for(i = 1; i <= num; i++)
    {
-      EntityPtr tmp, *ptr;
+      EntityHandle tmp, *ptr;
 
       targetList.AddObject(tmp);
       ptr = targetList.AddressOfObjectAt(i);
@@ -750,7 +750,7 @@ inline EXPORT_FROM_DLL void Actor::Unarchive(Archiver &arc)
    nearbyList.Resize(num);
    for(i = 1; i <= num; i++)
    {
-      EntityPtr tmp, *ptr;
+      EntityHandle tmp, *ptr;
 
       nearbyList.AddObject(tmp);
       ptr = nearbyList.AddressOfObjectAt(i);
@@ -762,7 +762,7 @@ inline EXPORT_FROM_DLL void Actor::Unarchive(Archiver &arc)
    enemyList.Resize(num);
    for(i = 1; i <= num; i++)
    {
-      EntityPtr tmp, *ptr;
+      EntityHandle tmp, *ptr;
 
       enemyList.AddObject(tmp);
       ptr = enemyList.AddressOfObjectAt(i);
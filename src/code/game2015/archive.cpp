@@ -246,6 +246,12 @@ void Archiver::Close(void)
             fixupptr = (SafePtrBase *)fixup->ptr;
             fixupptr->InitSafePtr(classptr);
          }
+         else if(fixup->type == pointer_fixup_handle)
+         {
+            HandleBase * fixupptr;
+            fixupptr = (HandleBase *)fixup->ptr;
+            fixupptr->InitHandle(classptr);
+         }
          delete fixup;
       }
       fixupList.FreeObjectList();
@@ -507,6 +513,35 @@ void Archiver::ReadSafePointer(SafePtrBase * ptr)
    }
 }
 
+// Handles are archived the same way as safe pointers, so a SafePtr can be
+// changed to a Handle without changing the savegame format.
+void Archiver::ReadSafePointer(HandleBase * handle)
+{
+   int index;
+   pointer_fixup_t *fixup;
+
+   ReadData(ARC_SafePointer, &index, sizeof(index));
+
+   // Check for a NULL pointer
+   assert(handle);
+   if(!handle)
+   {
+      FileError("NULL pointer in ReadSafePointer.");
+   }
+
+   // init the handle with NULL until we can fix it
+   handle->Clear();
+
+   if(index != ARCHIVE_NULL_POINTER)
+   {
+      fixup = new pointer_fixup_t();
+      fixup->ptr = (void **)handle;
+      fixup->index = index;
+      fixup->type = pointer_fixup_handle;
+      fixupList.AddObject(fixup);
+   }
+}
+
 Event Archiver::ReadEvent(void)
 {
    Event ev;
@@ -30,7 +30,8 @@
 enum
 {
    pointer_fixup_normal,
-   pointer_fixup_safe
+   pointer_fixup_safe,
+   pointer_fixup_handle
 };
 
 typedef struct
@@ -132,6 +133,7 @@ public:
    void           ReadString(str * string);
    void           ReadObjectPointer(Class ** ptr);
    void           ReadSafePointer(SafePtrBase * ptr);
+   void           ReadSafePointer(HandleBase * handle);
    void           ReadEvent(Event * ev);
 
    void           ReadRaw(void *data, size_t size);
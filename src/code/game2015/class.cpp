@@ -20,15 +20,51 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <ctype.h>
 #include "g_local.h"
 #include "class.h"
 #include "linklist.h"
+#include "../elib/qstringmap.h"
 
 int totalmemallocated = 0;
 int numclassesallocated = 0;
 
 static ClassDef *classlist = nullptr;
 
+// Index of the classes built once they've all registered themselves.  Until
+// then (and if a class is added or removed afterwards) lookups fall back to
+// walking classlist.
+static auto classNameKeyFunc = [] (const ClassDef *c) { return c->classname; };
+static auto classIDKeyFunc   = [] (const ClassDef *c) { return c->classID; };
+
+class ClassNameMap : public qstringmap<const ClassDef *, decltype(classNameKeyFunc), qstring::caseequal>
+{
+public:
+   using qstringmap::qstringmap;
+};
+
+class ClassIDMap : public qstringmap<const ClassDef *, decltype(classIDKeyFunc), qstring::caseequal>
+{
+public:
+   using qstringmap::qstringmap;
+};
+
+static ClassDef     **classes      = nullptr;
+static int            numclasses   = 0;
+static ClassNameMap  *classNameMap = nullptr;
+static ClassIDMap    *classIDMap   = nullptr;
+
+static void ClearClassIndex()
+{
+   delete[] classes;
+   delete classNameMap;
+   delete classIDMap;
+   classes      = nullptr;
+   classNameMap = nullptr;
+   classIDMap   = nullptr;
+   numclasses   = 0;
+}
+
 ClassDef::ClassDef()
 {
    this->prev = this;
@@ -48,7 +84,7 @@ ClassDef::ClassDef(const char *classname, const char *classID, const char *super
    this->superclass     = superclass;
    this->responses      = responses;
    this->numEvents      = 0;
-   this->responseLookup = nullptr;
+   this->responsePages  = nullptr;
    this->newInstance    = newInstance;
    this->classSize      = classSize;
    this->super          = getClass(superclass);
@@ -72,6 +108,8 @@ ClassDef::ClassDef(const char *classname, const char *classID, const char *super
 
    // Add to front of list
    LL_Add(classlist, this, prev, next);
+
+   ClearClassIndex();
 }
 
 ClassDef::~ClassDef()
@@ -81,6 +119,7 @@ ClassDef::~ClassDef()
    if(classlist != this)
    {
       LL_Remove(this, prev, next);
+      ClearClassIndex();
 
       // Check if any subclasses were initialized before their superclass
       for(node = classlist->next; node != classlist; node = node->next)
@@ -97,31 +136,127 @@ ClassDef::~ClassDef()
       assert(this->next == this->prev);
    }
 
-   if(responseLookup)
+   if(responsePages)
+   {
+      delete [] responsePages;
+      responsePages = nullptr;
+   }
+}
+
+/*
+==============================================================================
+
+Response pages
+
+Most classes respond to the same events as their superclass, and most event
+numbers have no response at all in a given class, so instead of a dense
+table per class, each class gets a directory of pages that are looked up in
+a pool and shared with every other class whose page has the same contents.
+
+==============================================================================
+*/
+
+#define RESPONSE_PAGE_HASH 1024
+
+typedef struct responsepage_s
+{
+   struct responsepage_s *next;
+   unsigned               hash;
+   Response              *entries[RESPONSE_PAGE_SIZE];
+} responsepage_t;
+
+static Response       *emptyResponsePage[RESPONSE_PAGE_SIZE];
+static responsepage_t *responsePageHash[RESPONSE_PAGE_HASH];
+static int             numResponsePages = 0;
+static int             numPageRefs      = 0;
+
+static void ClearResponsePages()
+{
+   responsepage_t *page;
+   responsepage_t *next;
+   int             i;
+
+   for(i = 0; i < RESPONSE_PAGE_HASH; i++)
+   {
+      for(page = responsePageHash[i]; page; page = next)
+      {
+         next = page->next;
+         delete page;
+      }
+      responsePageHash[i] = nullptr;
+   }
+
+   numResponsePages = 0;
+   numPageRefs = 0;
+}
+
+static Response **ShareResponsePage(Response **entries)
+{
+   responsepage_t *page;
+   unsigned        hash;
+   qboolean        empty;
+   int             i;
+
+   numPageRefs++;
+
+   empty = true;
+   for(i = 0; i < RESPONSE_PAGE_SIZE; i++)
+   {
+      if(entries[i])
+      {
+         empty = false;
+         break;
+      }
+   }
+
+   if(empty)
+   {
+      return emptyResponsePage;
+   }
+
+   hash = G_HashData(entries, RESPONSE_PAGE_SIZE * sizeof(entries[0]));
+
+   for(page = responsePageHash[hash & (RESPONSE_PAGE_HASH - 1)]; page; page = page->next)
    {
-      delete [] responseLookup;
-      responseLookup = nullptr;
+      if((page->hash == hash) && !memcmp(page->entries, entries, sizeof(page->entries)))
+      {
+         return page->entries;
+      }
    }
+
+   page = new responsepage_t;
+   page->hash = hash;
+   memcpy(page->entries, entries, sizeof(page->entries));
+   page->next = responsePageHash[hash & (RESPONSE_PAGE_HASH - 1)];
+   responsePageHash[hash & (RESPONSE_PAGE_HASH - 1)] = page;
+   numResponsePages++;
+
+   return page->entries;
 }
 
 EXPORT_FROM_DLL void ClassDef::BuildResponseList()
 {
    const ClassDef *c;
    ResponseDef    *r;
+   Response      **lookup;
    int             ev;
    int             i;
    qboolean       *set;
    int             num;
+   int             numpages;
 
-   if(responseLookup)
+   if(responsePages)
    {
-      delete [] responseLookup;
-      responseLookup = nullptr;
+      delete [] responsePages;
+      responsePages = nullptr;
    }
 
    num = Event::NumEventCommands();
-   responseLookup = reinterpret_cast<Response **>(new char[sizeof(Response *) * num]);
-   memset(responseLookup, 0, sizeof(Response *) * num);
+   numpages = (num + RESPONSE_PAGE_SIZE - 1) >> RESPONSE_PAGE_SHIFT;
+
+   // build the dense table in scratch space, then split it into shared pages
+   lookup = new Response *[numpages << RESPONSE_PAGE_SHIFT];
+   memset(lookup, 0, sizeof(Response *) * (numpages << RESPONSE_PAGE_SHIFT));
 
    set = new qboolean [num];
    memset(set, 0, sizeof(qboolean) * num);
@@ -141,44 +276,172 @@ EXPORT_FROM_DLL void ClassDef::BuildResponseList()
                set[ev] = true;
                if(r[i].response)
                {
-                  responseLookup[ev] = &r[i].response;
+                  lookup[ev] = &r[i].response;
                }
                else
                {
-                  responseLookup[ev] = nullptr;
+                  lookup[ev] = nullptr;
                }
             }
          }
       }
    }
 
+   responsePages = new Response **[numpages];
+   for(i = 0; i < numpages; i++)
+   {
+      responsePages[i] = ShareResponsePage(&lookup[i << RESPONSE_PAGE_SHIFT]);
+   }
+
    delete [] set;
+   delete [] lookup;
+}
+
+/*
+====================
+BuildClassIndex
+
+Gives every class its classnum and builds the name and id hashes.  Called
+once all the classes have registered themselves.
+====================
+*/
+static void BuildClassIndex(int num)
+{
+   ClassDef *c;
+   int       i;
+
+   ClearClassIndex();
+
+   numclasses = num;
+   classes = new ClassDef *[numclasses];
+
+   classNameMap = new ClassNameMap(classNameKeyFunc);
+   classIDMap = new ClassIDMap(classIDKeyFunc);
+
+   i = 0;
+   for(c = classlist->next; c != classlist; c = c->next, i++)
+   {
+      classes[i] = c;
+      c->classnum = i;
+
+      // insert keeps the first class with the name, the same one a walk of
+      // the list finds
+      classNameMap->insert(c);
+      if(c->classID[0])
+      {
+         classIDMap->insert(c);
+      }
+   }
+
+   for(i = 0; i < numclasses; i++)
+   {
+      c = classes[i];
+      c->idclass = c->classID[0] ? classes[getClassForID(c->classID)->classnum] : nullptr;
+   }
+}
+
+static void NumberClass(const int *firstchild, const int *nextsibling, int index, int &num)
+{
+   int i;
+
+   classes[index]->treeEnter = num++;
+   for(i = firstchild[index]; i >= 0; i = nextsibling[i])
+   {
+      NumberClass(firstchild, nextsibling, i, num);
+   }
+   classes[index]->treeExit = num;
+}
+
+/*
+====================
+NumberClassTree
+
+Numbers the classes in pre-order so that checking whether one class inherits
+from another is a range check instead of a walk up the superclass chain.
+====================
+*/
+static void NumberClassTree()
+{
+   int *firstchild;
+   int *nextsibling;
+   int  parent;
+   int  num;
+   int  i;
+
+   firstchild  = new int[numclasses];
+   nextsibling = new int[numclasses];
+
+   for(i = 0; i < numclasses; i++)
+   {
+      firstchild[i] = -1;
+      nextsibling[i] = -1;
+   }
+
+   for(i = numclasses - 1; i >= 0; i--)
+   {
+      if(classes[i]->super)
+      {
+         parent = classes[i]->super->classnum;
+         nextsibling[i] = firstchild[parent];
+         firstchild[parent] = i;
+      }
+   }
+
+   // every root starts its own range, so the numbers are unique across the whole list
+   num = 0;
+   for(i = 0; i < numclasses; i++)
+   {
+      if(!classes[i]->super)
+      {
+         NumberClass(firstchild, nextsibling, i, num);
+      }
+   }
+
+   delete[] firstchild;
+   delete[] nextsibling;
 }
 
 EXPORT_FROM_DLL void BuildEventResponses()
 {
    ClassDef *c;
    int amount;
-   int numclasses;
+   int dense;
+   int num;
+
+   ClearResponsePages();
 
    amount = 0;
-   numclasses = 0;
+   dense = 0;
+   num = 0;
    for(c = classlist->next; c != classlist; c = c->next)
    {
       c->BuildResponseList();
 
-      amount += c->numEvents * sizeof(Response *);
-      numclasses++;
+      amount += ((c->numEvents + RESPONSE_PAGE_SIZE - 1) >> RESPONSE_PAGE_SHIFT) * sizeof(Response **);
+      dense += c->numEvents * sizeof(Response *);
+      num++;
    }
 
+   amount += numResponsePages * sizeof(responsepage_t) + sizeof(emptyResponsePage);
+
+   BuildClassIndex(num);
+   NumberClassTree();
+
    gi.dprintf("\n------------------\n"
               "Event system initialized:\n"
-              "%d classes\n%d events\n%d total memory in response list\n\n",
-              numclasses, Event::NumEventCommands(), amount);
+              "%d classes\n%d events\n%d total memory in response list\n"
+              "%d of %d response pages shared (%d bytes saved)\n\n",
+              numclasses, Event::NumEventCommands(), amount,
+              numPageRefs - numResponsePages, numPageRefs, dense - amount);
 }
 
 EXPORT_FROM_DLL const ClassDef *getClassForID(const char *name)
 {
+   if(classIDMap)
+   {
+      return classIDMap->find(name);
+   }
+
    for(const ClassDef *c = classlist->next; c != classlist; c = c->next)
    {
       if(c->classID && !Q_stricmp(c->classID, name))
@@ -192,6 +455,11 @@ EXPORT_FROM_DLL const ClassDef *getClassForID(const char *name)
 
 EXPORT_FROM_DLL const ClassDef *getClass(const char *name)
 {
+   if(classNameMap)
+   {
+      return classNameMap->find(name);
+   }
+
    for(const ClassDef *c = classlist->next; c != classlist; c = c->next)
    {
       if(!Q_stricmp(c->classname, name))
@@ -208,6 +476,21 @@ EXPORT_FROM_DLL const ClassDef *getClassList()
    return classlist;
 }
 
+EXPORT_FROM_DLL const ClassDef *getClassForNum(int classnum)
+{
+   if((classnum < 0) || (classnum >= numclasses))
+   {
+      return nullptr;
+   }
+
+   return classes[classnum];
+}
+
+EXPORT_FROM_DLL int numClasses()
+{
+   return numclasses;
+}
+
 EXPORT_FROM_DLL void listAllClasses()
 {
    for(const ClassDef *c = classlist->next; c != classlist; c = c->next)
@@ -232,14 +515,95 @@ EXPORT_FROM_DLL void listInheritanceOrder(const char *classname)
 
 EXPORT_FROM_DLL qboolean checkInheritance(const ClassDef *superclass, const ClassDef *subclass)
 {
-   for(const ClassDef *c = subclass; c != nullptr; c = c->super)
+   return subclass->inheritsFrom(superclass);
+}
+
+/*
+====================
+ClassInheritanceBenchmark
+
+Times inheritance checks from the class with the deepest hierarchy against
+every class, once walking the superclass chain the way checkInheritance used
+to and once with the class tree numbering.
+====================
+*/
+EXPORT_FROM_DLL void ClassInheritanceBenchmark(int count)
+{
+   const ClassDef *deepest;
+   const ClassDef *s;
+   long long       start;
+   long long       walktime;
+   long long       treetime;
+   int             depth;
+   int             maxdepth;
+   int             walkhits;
+   int             treehits;
+   int             i;
+   int             j;
+
+   if(!numclasses)
+   {
+      gi.printf("Classes haven't been numbered yet.\n");
+      return;
+   }
+
+   deepest = nullptr;
+   maxdepth = 0;
+   for(i = 0; i < numclasses; i++)
    {
-      if(c == superclass)
+      depth = 0;
+      for(s = classes[i]; s != nullptr; s = s->super)
+      {
+         depth++;
+      }
+
+      if(depth > maxdepth)
       {
-         return true;
+         maxdepth = depth;
+         deepest = classes[i];
       }
    }
-   return false;
+
+   if(count < 1)
+   {
+      count = 1;
+   }
+
+   walkhits = 0;
+   start = G_Nanoseconds();
+   for(j = 0; j < count; j++)
+   {
+      for(i = 0; i < numclasses; i++)
+      {
+         for(s = deepest; s != nullptr; s = s->super)
+         {
+            if(s == classes[i])
+            {
+               walkhits++;
+               break;
+            }
+         }
+      }
+   }
+   walktime = G_Nanoseconds() - start;
+
+   treehits = 0;
+   start = G_Nanoseconds();
+   for(j = 0; j < count; j++)
+   {
+      for(i = 0; i < numclasses; i++)
+      {
+         if(deepest->inheritsFrom(classes[i]))
+         {
+            treehits++;
+         }
+      }
+   }
+   treetime = G_Nanoseconds() - start;
+
+   gi.printf("%s has %d levels, checked against %d classes %d times\n", deepest->classname, maxdepth, numclasses, count);
+   gi.printf("walk %8.2f ms   tree %8.2f ms   results %s\n", (float)(walktime / 1000000.0), (float)(treetime / 1000000.0),
+             (walkhits == treehits) ? "match" : "DIFFER");
 }
 
 EXPORT_FROM_DLL qboolean checkInheritance(const ClassDef *superclass, const char *subclass)
@@ -278,75 +642,343 @@ ResponseDef Class::Responses[] =
    { nullptr, nullptr }
 };
 
-#ifdef NDEBUG
+/*
+==============================================================================
 
-EXPORT_FROM_DLL void *Class::operator new (size_t s)
+Class allocation
+
+Instances are allocated from slabs with a free list for each size bucket, so
+the objects that come and go all the time (gibs, projectiles, spawn args)
+reuse each other's memory instead of fragmenting the heap.  Anything too big
+for the largest bucket goes straight to the heap.  Every block starts with a
+header that records the class it's charged to.
+
+==============================================================================
+*/
+
+#define CLASS_BLOCK_MAGIC   0x12348765
+#define CLASS_BLOCK_TAIL    0x56784321
+
+#define CLASS_SLAB_GRAIN    16
+#define CLASS_SLAB_MAXSIZE  4096
+#define CLASS_SLAB_BUCKETS  ( CLASS_SLAB_MAXSIZE / CLASS_SLAB_GRAIN )
+#define CLASS_SLAB_CHUNK    65536
+
+typedef struct classblock_s
 {
-   int *p;
+   ClassDef *cls;
+   int       size;      // size of the whole block, header included
+   int       magic;
+} classblock_t;
 
-   s += sizeof(int);
-   p = reinterpret_cast<int *>(::new char [s]);
-   memset(p, 0, s);
-   *p = s;
-   totalmemallocated += s;
-   numclassesallocated++;
-   return p + 1;
+// keep the object itself 8 byte aligned
+#define CLASS_HEADER_SIZE   ( ( sizeof( classblock_t ) + 7 ) & ~7 )
+
+typedef union classslot_u
+{
+   union classslot_u *next;
+} classslot_t;
+
+static classslot_t *slabFree[CLASS_SLAB_BUCKETS];
+static int          slabBlocks[CLASS_SLAB_BUCKETS];
+static int          slabUsed[CLASS_SLAB_BUCKETS];
+static int          slabBytes = 0;
+static int          heapBlocks = 0;
+static int          heapBytes = 0;
+
+static void GrowSlab(int bucket)
+{
+   byte *chunk;
+   int   blocksize;
+   int   chunksize;
+   int   i;
+
+   blocksize = (bucket + 1) * CLASS_SLAB_GRAIN;
+   chunksize = CLASS_SLAB_CHUNK;
+   if(chunksize < blocksize * 8)
+   {
+      chunksize = blocksize * 8;
+   }
+
+   chunk = ::new byte[chunksize];
+   slabBytes += chunksize;
+
+   for(i = chunksize / blocksize - 1; i >= 0; i--)
+   {
+      classslot_t *slot = reinterpret_cast<classslot_t *>(chunk + i * blocksize);
+      slot->next = slabFree[bucket];
+      slabFree[bucket] = slot;
+      slabBlocks[bucket]++;
+   }
 }
 
-EXPORT_FROM_DLL void Class::operator delete (void *ptr)
+EXPORT_FROM_DLL void *Class::AllocInstance(size_t s, ClassDef *cls)
 {
-   int *p;
+   classblock_t *block;
+   int           size;
+   int           bucket;
 
-   p = (reinterpret_cast<int *>(ptr)) - 1;
-   totalmemallocated -= *p;
-   numclassesallocated--;
-   ::delete [] (p);
+   size = CLASS_HEADER_SIZE + (int)s;
+#ifndef NDEBUG
+   size += sizeof(int);
+#endif
+
+   bucket = (size - 1) / CLASS_SLAB_GRAIN;
+   if(bucket < CLASS_SLAB_BUCKETS)
+   {
+      if(!slabFree[bucket])
+      {
+         GrowSlab(bucket);
+      }
+
+      size = (bucket + 1) * CLASS_SLAB_GRAIN;
+      block = reinterpret_cast<classblock_t *>(slabFree[bucket]);
+      slabFree[bucket] = slabFree[bucket]->next;
+      slabUsed[bucket]++;
+   }
+   else
+   {
+      block = reinterpret_cast<classblock_t *>(::new byte[size]);
+      heapBlocks++;
+      heapBytes += size;
+   }
+
+   memset(block, 0, size);
+   block->cls = cls;
+   block->size = size;
+   block->magic = CLASS_BLOCK_MAGIC;
+#ifndef NDEBUG
+   *reinterpret_cast<int *>(reinterpret_cast<byte *>(block) + size - sizeof(int)) = CLASS_BLOCK_TAIL;
+#endif
+
+   cls->AddInstance(size);
+   totalmemallocated += size;
+   numclassesallocated++;
+
+   return reinterpret_cast<byte *>(block) + CLASS_HEADER_SIZE;
+}
+
+EXPORT_FROM_DLL void *Class::operator new (size_t s)
+{
+   return AllocInstance(s, &ClassInfo);
 }
 
-#else
+/*
+====================
+AllocatedClass
 
-EXPORT_FROM_DLL void * Class::operator new (size_t s)
+Returns the class obj was allocated as.  Unlike classinfo, this is already
+the most derived class while the base class constructors are running.
+====================
+*/
+EXPORT_FROM_DLL const ClassDef *Class::AllocatedClass(const Class *obj)
 {
-   int *p;
+   const classblock_t *block;
 
-   s += sizeof(int) * 3;
-   p = reinterpret_cast<int *>(::new char [s]);
-   memset(p, 0, s);
-   p[0] = 0x12348765;
-   *reinterpret_cast<int *>((reinterpret_cast<byte *>(p)) + s - sizeof(int)) = 0x56784321;
-   p[1] = s;
-   totalmemallocated += s;
-   numclassesallocated++;
-   return p + 2;
+   block = reinterpret_cast<const classblock_t *>(reinterpret_cast<const byte *>(obj) - CLASS_HEADER_SIZE);
+   if(block->magic != CLASS_BLOCK_MAGIC)
+   {
+      return obj->classinfo();
+   }
+
+   return block->cls;
 }
 
 EXPORT_FROM_DLL void Class::operator delete (void *ptr)
 {
-   int *p;
+   classblock_t *block;
+   classslot_t  *slot;
+   int           bucket;
+
+   if(!ptr)
+   {
+      return;
+   }
 
-   p = (reinterpret_cast<int *>(ptr)) - 2;
+   block = reinterpret_cast<classblock_t *>(reinterpret_cast<byte *>(ptr) - CLASS_HEADER_SIZE);
 
-   assert(p[0] == 0x12348765);
-   assert(*reinterpret_cast<int *>((reinterpret_cast<byte *>(p)) + p[1] - sizeof(int)) == 0x56784321);
+   assert(block->magic == CLASS_BLOCK_MAGIC);
+   assert(*reinterpret_cast<int *>(reinterpret_cast<byte *>(block) + block->size - sizeof(int)) == CLASS_BLOCK_TAIL);
 
-   totalmemallocated -= p[1];
+   block->cls->RemoveInstance(block->size);
+   totalmemallocated -= block->size;
    numclassesallocated--;
-   ::delete [] (p);
+
+   bucket = (block->size - 1) / CLASS_SLAB_GRAIN;
+   if(bucket < CLASS_SLAB_BUCKETS)
+   {
+      block->magic = 0;
+      slot = reinterpret_cast<classslot_t *>(block);
+      slot->next = slabFree[bucket];
+      slabFree[bucket] = slot;
+      slabUsed[bucket]--;
+   }
+   else
+   {
+      heapBlocks--;
+      heapBytes -= block->size;
+      ::delete[] reinterpret_cast<byte *>(block);
+   }
 }
 
-#endif
+/*
+==============================================================================
+
+Handle slots
+
+Slot 0 is never handed out so that a zeroed handle is always null.  Freed
+slots go on a free list and get their serial bumped, so handles still
+referring to them stop resolving.
+
+==============================================================================
+*/
+
+#define HANDLE_SLOTS_START 1024
+
+classhandleslot_t *classHandleSlots = nullptr;
+static int         numHandleSlots   = 0;
+static int         freeHandleSlot   = 0;
+
+EXPORT_FROM_DLL int AllocHandleSlot(Class *ptr)
+{
+   classhandleslot_t *slots;
+   int                index;
+   int                num;
+   int                i;
+
+   if(!freeHandleSlot)
+   {
+      num = numHandleSlots ? numHandleSlots * 2 : HANDLE_SLOTS_START;
+      slots = new classhandleslot_t[num];
+      if(classHandleSlots)
+      {
+         memcpy(slots, classHandleSlots, sizeof(classhandleslot_t) * numHandleSlots);
+         delete[] classHandleSlots;
+      }
+
+      for(i = num - 1; i >= numHandleSlots; i--)
+      {
+         slots[i].ptr = nullptr;
+         slots[i].serial = 1;
+         slots[i].nextfree = freeHandleSlot;
+         freeHandleSlot = i;
+      }
+
+      // slot 0 stays unused
+      if(!numHandleSlots)
+      {
+         freeHandleSlot = slots[0].nextfree;
+         slots[0].serial = 0;
+      }
+
+      classHandleSlots = slots;
+      numHandleSlots = num;
+   }
+
+   index = freeHandleSlot;
+   freeHandleSlot = classHandleSlots[index].nextfree;
+   classHandleSlots[index].ptr = ptr;
+
+   return index;
+}
+
+EXPORT_FROM_DLL void FreeHandleSlot(int index)
+{
+   classhandleslot_t *slot;
+
+   slot = &classHandleSlots[index];
+
+   slot->ptr = nullptr;
+   if(!++slot->serial)
+   {
+      slot->serial = 1;
+   }
+   slot->nextfree = freeHandleSlot;
+   freeHandleSlot = index;
+}
 
 EXPORT_FROM_DLL void DisplayMemoryUsage()
 {
    gi.printf("Classes %-5d Class memory used: %d\n", numclassesallocated, totalmemallocated);
 }
 
+static int CompareClassMemory(const void *arg1, const void *arg2)
+{
+   const ClassDef *c1 = *(const ClassDef **)arg1;
+   const ClassDef *c2 = *(const ClassDef **)arg2;
+
+   if(c1->liveBytes != c2->liveBytes)
+   {
+      return c2->liveBytes - c1->liveBytes;
+   }
+
+   return c2->peakBytes - c1->peakBytes;
+}
+
+/*
+====================
+DisplayClassMemoryUsage
+
+Lists the num classes using the most memory, along with how much of the
+slabs is in use.
+====================
+*/
+EXPORT_FROM_DLL void DisplayClassMemoryUsage(int num)
+{
+   const ClassDef **sorted;
+   const ClassDef  *c;
+   int              count;
+   int              used;
+   int              i;
+
+   used = 0;
+   for(i = 0; i < CLASS_SLAB_BUCKETS; i++)
+   {
+      used += slabUsed[i] * (i + 1) * CLASS_SLAB_GRAIN;
+   }
+
+   gi.printf("Slabs %d of %d bytes in use, heap %d bytes in %d blocks\n", used, slabBytes, heapBytes, heapBlocks);
+
+   count = 0;
+   for(c = classlist->next; c != classlist; c = c->next)
+   {
+      count++;
+   }
+
+   sorted = new const ClassDef *[count + 1];
+   count = 0;
+   for(c = classlist->next; c != classlist; c = c->next)
+   {
+      if(c->peakInstances)
+      {
+         sorted[count++] = c;
+      }
+   }
+
+   qsort(sorted, count, sizeof(const ClassDef *), CompareClassMemory);
+
+   gi.printf("%-24s %7s %7s %9s %9s %9s\n", "class", "live", "peak", "bytes", "peakbytes", "allocs");
+   for(i = 0; (i < count) && (i < num); i++)
+   {
+      c = sorted[i];
+      gi.printf("%-24s %7d %7d %9d %9d %9d\n", c->classname, c->liveInstances, c->peakInstances,
+                c->liveBytes, c->peakBytes, c->totalInstances);
+   }
+
+   delete[] sorted;
+}
+
 Class::~Class()
 {
    while(SafePtrList != nullptr)
    {
       SafePtrList->Clear();
    }
+
+   if(handleIndex && (classHandleSlots[handleIndex].ptr == this))
+   {
+      FreeHandleSlot(handleIndex);
+   }
 }
 
 EXPORT_FROM_DLL void Class::Archive(Archiver &arc)
@@ -32,6 +32,10 @@ typedef struct
    Response	response;
 } ResponseDef;
 
+#define RESPONSE_PAGE_SHIFT 5
+#define RESPONSE_PAGE_SIZE  ( 1 << RESPONSE_PAGE_SHIFT )
+#define RESPONSE_PAGE_MASK  ( RESPONSE_PAGE_SIZE - 1 )
+
 /***********************************************************************
 
   ClassDef
@@ -48,18 +52,101 @@ public:
    int              classSize        = 0;
    ResponseDef     *responses        = nullptr;
    int              numEvents        = 0;
-   Response       **responseLookup   = nullptr;
+   // Two level response table indexed by event number.  Pages with the same
+   // contents are shared between classes, and pages with no responses all
+   // point at one empty page, so a lookup is always two loads.
+   Response      ***responsePages    = nullptr;
    const ClassDef  *super            = nullptr;
    ClassDef        *next;
    ClassDef        *prev;
 
+   // Pre-order numbering of the class tree.  Every subclass of this class,
+   // and only those, has a treeEnter in [treeEnter, treeExit).  treeExit is
+   // 0 until BuildEventResponses has numbered the tree.
+   int              treeEnter        = 0;
+   int              treeExit         = 0;
+
+   // Dense index of the class, usable for arrays indexed by class.  -1 until
+   // BuildEventResponses has built the class index.
+   int              classnum         = -1;
+
+   // Class that owns the entity list for this class's id.  Classes can share
+   // an id, in which case they all use the first one with it.  Null for
+   // classes without an id.
+   ClassDef        *idclass          = nullptr;
+
+   // Live entities with this class id, in entity number order.  Maintained
+   // by G_AddClassEntity and G_RemoveClassEntity.
+   int              firstEntity      = -1;
+   int              lastEntity       = -1;
+   int              numEntities      = 0;
+
+   // Memory charged to the class by the class allocators.  These don't have
+   // initializers so that instances allocated before a ClassDef is
+   // constructed during static initialization still count; static storage
+   // starts out zeroed anyway.
+   int              liveInstances;
+   int              peakInstances;
+   int              totalInstances;
+   int              liveBytes;
+   int              peakBytes;
+
    ClassDef();
    ~ClassDef();
    ClassDef(const char *classname, const char *classID, const char *superclass,
             ResponseDef *responses, void *(*newInstance)(), int classSize);
    void BuildResponseList();
+   qboolean inheritsFrom(const ClassDef *c) const;
+   Response *GetResponse(int ev) const;
+   void AddInstance(int bytes);
+   void RemoveInstance(int bytes);
 };
 
+inline void ClassDef::AddInstance(int bytes)
+{
+   totalInstances++;
+   if(++liveInstances > peakInstances)
+   {
+      peakInstances = liveInstances;
+   }
+
+   liveBytes += bytes;
+   if(liveBytes > peakBytes)
+   {
+      peakBytes = liveBytes;
+   }
+}
+
+inline void ClassDef::RemoveInstance(int bytes)
+{
+   liveInstances--;
+   liveBytes -= bytes;
+}
+
+inline Response *ClassDef::GetResponse(int ev) const
+{
+   return responsePages[ev >> RESPONSE_PAGE_SHIFT][ev & RESPONSE_PAGE_MASK];
+}
+
+inline qboolean ClassDef::inheritsFrom(const ClassDef *c) const
+{
+   if(treeExit && c->treeExit)
+   {
+      return (treeEnter >= c->treeEnter) && (treeEnter < c->treeExit);
+   }
+
+   // classes haven't been numbered yet
+   for(const ClassDef *s = this; s != nullptr; s = s->super)
+   {
+      if(s == c)
+      {
+         return true;
+      }
+   }
+
+   return false;
+}
+
 /***********************************************************************
 
   SafePtr
@@ -88,6 +175,39 @@ public:
    void        Clear();
 };
 
+/***********************************************************************
+
+  Handle
+
+  A generational reference to an object.  Handles are a slot index and the
+  serial the slot had when the handle was made; destroying the object bumps
+  the serial, which invalidates every handle to it without touching them.
+  Unlike SafePtr, copying a handle never touches the object, so they can be
+  copied around freely.
+
+***********************************************************************/
+
+typedef struct
+{
+   Class    *ptr;
+   unsigned  serial;
+   int       nextfree;
+} classhandleslot_t;
+
+extern classhandleslot_t *classHandleSlots;
+
+class HandleBase
+{
+public:
+   // serial 0 is never valid, so a zeroed handle is null
+   int         index  = 0;
+   unsigned    serial = 0;
+
+   Class      *GetPtr() const noexcept;
+   void        InitHandle(Class *newptr);
+   void        Clear() noexcept;
+};
+
 /***********************************************************************
 
   Class
@@ -117,24 +237,40 @@ public:
    virtual  const ClassDef *classinfo() const; \
    static   ResponseDef    Responses[];
 
-#define CLASS_PROTOTYPE( nameofclass )                  \
+// For classes that provide their own operator new and charge their
+// ClassInfo themselves
+#define CLASS_PROTOTYPE_NOALLOC( nameofclass )          \
    public:                                              \
    static   ClassDef       ClassInfo;                   \
    static   void           *_newInstance();             \
    virtual  const ClassDef *classinfo() const override; \
    static   ResponseDef    Responses[];
 
+#define CLASS_PROTOTYPE( nameofclass )                  \
+   CLASS_PROTOTYPE_NOALLOC( nameofclass )               \
+   static void *operator new (size_t s)                 \
+   {                                                    \
+      return Class::AllocInstance(s, &ClassInfo);       \
+   }
+
 class Class
 {
 private:
    SafePtrBase	 *SafePtrList = nullptr;
    friend class SafePtrBase;
 
+   // slot in the handle table, allocated the first time a handle is made
+   int          handleIndex = 0;
+   friend class HandleBase;
+
 public:
    CLASS_PROTOTYPE_BASE(Class);
    void *operator    new (size_t);
    void  operator    delete (void *);
 
+   static void      *AllocInstance(size_t s, ClassDef *cls);
+   static const ClassDef *AllocatedClass(const Class *obj);
+
    virtual           ~Class();
    virtual void      Archive(Archiver &arc);
    virtual void      Unarchive(Archiver &arc);
@@ -160,21 +296,25 @@ void              BuildEventResponses();
 const ClassDef   *getClassForID(const char *name);
 const ClassDef   *getClass(const char *name);
 const ClassDef   *getClassList();
+const ClassDef   *getClassForNum(int classnum);
+int               numClasses();
 void              listAllClasses();
 void              listInheritanceOrder(const char *classname);
 qboolean          checkInheritance(const ClassDef *superclass, const ClassDef *subclass);
 qboolean          checkInheritance(const ClassDef *superclass, const char *subclass);
 qboolean          checkInheritance(const char *superclass, const char *subclass);
 void              DisplayMemoryUsage();
+void              DisplayClassMemoryUsage(int num);
+void              ClassInheritanceBenchmark(int count);
 
 inline qboolean Class::inheritsFrom(const ClassDef *c) const
 {
-   return checkInheritance(c, classinfo());
+   return classinfo()->inheritsFrom(c);
 }
 
 inline qboolean Class::isInheritedBy(const ClassDef *c) const
 {
-   return checkInheritance(classinfo(), c);
+   return c->inheritsFrom(classinfo());
 }
 
 /***********************************************************************
@@ -340,6 +480,118 @@ template class SafePtr<Class>;
 #endif
 typedef SafePtr<Class> ClassPtr;
 
+/***********************************************************************
+
+  Handle
+
+***********************************************************************/
+
+int               AllocHandleSlot(Class *ptr);
+void              FreeHandleSlot(int index);
+
+inline Class *HandleBase::GetPtr() const noexcept
+{
+   if(serial && (classHandleSlots[index].serial == serial))
+   {
+      return classHandleSlots[index].ptr;
+   }
+
+   return nullptr;
+}
+
+inline void HandleBase::InitHandle(Class *newptr)
+{
+   if(!newptr)
+   {
+      Clear();
+      return;
+   }
+
+   // copies of an object carry its slot along, so check that it's really ours
+   if(!newptr->handleIndex || (classHandleSlots[newptr->handleIndex].ptr != newptr))
+   {
+      newptr->handleIndex = AllocHandleSlot(newptr);
+   }
+
+   index = newptr->handleIndex;
+   serial = classHandleSlots[index].serial;
+}
+
+inline void HandleBase::Clear() noexcept
+{
+   index = 0;
+   serial = 0;
+}
+
+template<class T>
+class Handle : public HandleBase
+{
+public:
+   Handle() noexcept = default;
+
+   Handle(T *objptr)
+   {
+      InitHandle(objptr);
+   }
+
+   Handle &operator = (T *const obj)
+   {
+      InitHandle(obj);
+      return *this;
+   }
+
+   operator T *() const noexcept
+   {
+      return (T *)GetPtr();
+   }
+
+   T *operator -> () const noexcept
+   {
+      return (T *)GetPtr();
+   }
+
+   T &operator * () const noexcept
+   {
+      return *(T *)GetPtr();
+   }
+};
+
+template<class T>
+inline int __cdecl operator == (const Handle<T> &a, const Handle<T> &b) noexcept
+{
+   return a.GetPtr() == b.GetPtr();
+}
+
+template<class T>
+inline int __cdecl operator != (const Handle<T> &a, const Handle<T> &b) noexcept
+{
+   return a.GetPtr() != b.GetPtr();
+}
+
+template<class T>
+inline int __cdecl operator == (const Handle<T> &a, T *b) noexcept
+{
+   return a.GetPtr() == b;
+}
+
+template<class T>
+inline int __cdecl operator != (const Handle<T> &a, T *b) noexcept
+{
+   return a.GetPtr() != b;
+}
+
+template<class T>
+inline int __cdecl operator == (T *a, const Handle<T> &b) noexcept
+{
+   return a == b.GetPtr();
+}
+
+template<class T>
+inline int __cdecl operator != (T *a, const Handle<T> &b) noexcept
+{
+   return a != b.GetPtr();
+}
+
 #include "archive.h"
 
 // EOF
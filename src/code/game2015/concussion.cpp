@@ -69,7 +69,7 @@ void ConcussionRing::Setup(Vector pos, Vector dir)
 //==================================================================
 
 Event EV_Concussion_Effect("concussion_effect");
-Event EV_Concussion_Regen("concussion_regen");
+Event EV_Concussion_Regen("concussion_regen", EV_COALESCE);
 
 CLASS_DECLARATION(Weapon, ConcussionGun, "weapon_concussiongun");
 
@@ -188,7 +188,6 @@ void ConcussionGun::Shoot(Event *ev)
    // post the battery regenerating event
    if(owner->isClient())
    {
-      CancelEventsOfType(EV_Concussion_Regen);
       PostEvent(EV_Concussion_Regen, CONCUSSION_REGEN_TIME);
    }
 }
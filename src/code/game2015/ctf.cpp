@@ -1483,7 +1483,7 @@ void CTF_Tech::Timeout(Event *ev)
 
 CLASS_DECLARATION(CTF_Tech, CTF_Tech_Regeneration, "ctf_tech_regeneration")
 
-Event EV_Tech_Regenerate("tech_regenerate");
+Event EV_Tech_Regenerate("tech_regenerate", EV_COALESCE);
 
 ResponseDef CTF_Tech_Regeneration::Responses[] =
 {
@@ -1526,7 +1526,6 @@ CTF_Tech_Regeneration::CTF_Tech_Regeneration(void) : CTF_Tech()
    setModel("ctf_regen.def");
    showModel();
 
-   CancelEventsOfType(EV_Tech_Regenerate);
    PostEvent(EV_Tech_Regenerate, 1);
    last_sound_event = 0;
 }
@@ -1609,7 +1608,7 @@ ResponseDef CTF_Tech_DeathQuad::Responses[] =
 CTF_Tech_DeathQuad::CTF_Tech_DeathQuad(void) : CTF_Tech()
 {
    setModel("ctf_deathquad.def");
-   PostEvent(EV_Tech_Damage, 1);
+   Schedule(EV_Tech_Damage, 1);
    showModel();
 }
 
@@ -1631,8 +1630,6 @@ void CTF_Tech_DeathQuad::Damage(Event *ev)
          last_sound_event = level.time + 2;
       }
    }
-
-   PostEvent(EV_Tech_Damage, 1);
 }
 
 //###
@@ -1693,7 +1690,7 @@ CTF_Tech_AmmoVortex::CTF_Tech_AmmoVortex(void) : CTF_Tech()
    last_type = NULL; // make addamount reset on first think
    addamount = 0;
 
-   PostEvent(EV_Tech_AddAmmo, 1);
+   Schedule(EV_Tech_AddAmmo, 1);
 }
 
 // ammo maxs for the hoverbike
@@ -1814,8 +1811,6 @@ void CTF_Tech_AmmoVortex::AddAmmo(Event *ev)
    {
       addamount = 0;
    }
-
-   PostEvent(EV_Tech_AddAmmo, 1);
 }
 //###
 
@@ -332,6 +332,8 @@ Entity::Entity() : Listener()
    client = edict->client;
    edict->entity = this;
    entnum = edict->s.number;
+   G_SpatialLink(this);
+   G_AddClassEntity(this);
 
    m = G_GetSpawnArg("classname");
    if(m)
@@ -559,6 +561,8 @@ Entity::~Entity()
    //###
 
    this->CancelPendingEvents();
+   G_SpatialUnlink(this);
+   G_RemoveClassEntity(this);
    G_FreeEdict(edict);
 }
 
@@ -566,6 +570,8 @@ EXPORT_FROM_DLL void Entity::SetEntNum(int num)
 {
    if(edict)
    {
+      G_SpatialUnlink(this);
+      G_RemoveClassEntity(this);
       G_FreeEdict(edict);
    }
 
@@ -577,6 +583,8 @@ EXPORT_FROM_DLL void Entity::SetEntNum(int num)
    client = edict->client;
    edict->entity = this;
    entnum = num;
+   G_SpatialLink(this);
+   G_AddClassEntity(this);
 }
 
 EXPORT_FROM_DLL void Entity::GetEntName(Event *ev)
@@ -946,6 +954,7 @@ EXPORT_FROM_DLL void Entity::link(void)
    absmax = edict->absmax;
    centroid = (absmin + absmax) * 0.5;
    centroid.copyTo(edict->centroid);
+   G_SpatialLink(this);
 
    // If this has a parent, then set the areanum the same
    // as the parent's
@@ -3126,10 +3135,15 @@ void Entity::RenderEffects(Event *ev)
    }
 }
 
+#define MAX_SOUND_HEARERS 256
+
 void Entity::BroadcastSound(Event *soundevent, int channel, Event &event, float radius)
 {
    Sentient *ent;
+   Entity   *other;
    Vector	delta;
+   int      hearers[MAX_SOUND_HEARERS];
+   qboolean usehash;
    Event		*ev;
    str		name;
    float    r2;
@@ -3151,10 +3165,32 @@ void Entity::BroadcastSound(Event *soundevent, int channel, Event &event, float
    if(((int)event != (int)NullEvent) && !(this->flags & FL_NOTARGET))
    {
       r2 = radius * radius;
-      n = SentientList.NumObjects();
+
+      // only look at what's nearby unless the sound carries too far for the
+      // spatial hash to be any help
+      n = G_SpatialRadius(centroid, radius, hearers, MAX_SOUND_HEARERS);
+      usehash = (n >= 0);
+      if(!usehash)
+      {
+         n = SentientList.NumObjects();
+      }
+
       for(i = 1; i <= n; i++)
       {
-         ent = SentientList.ObjectAt(i);
+         if(usehash)
+         {
+            other = G_GetEntity(hearers[i - 1]);
+            if(!other || !other->isSubclassOf<Sentient>())
+            {
+               continue;
+            }
+            ent = (Sentient *)other;
+         }
+         else
+         {
+            ent = SentientList.ObjectAt(i);
+         }
+
          if(ent->deadflag || (ent == this))
          {
             continue;
@@ -41,6 +41,7 @@
 #include "vector.h"
 #include "script.h"
 #include "listener.h"
+#include "spatialhash.h"
 
 #include <float.h>
 
@@ -248,10 +249,12 @@ class ScriptMaster;
 #define MAX_MODEL_CHILDREN 8
 
 class Entity;
+class TargetList;
 #ifdef EXPORT_TEMPLATE
 template class EXPORT_FROM_DLL SafePtr<Entity>;
 #endif
 typedef SafePtr<Entity> EntityPtr;
+typedef Handle<Entity> EntityHandle;
 
 class EXPORT_FROM_DLL Entity : public Listener
 {
@@ -338,6 +341,16 @@ public:
    str               killtarget2;
    //###
 
+   // The target lists this entity is in (one for each targetname) and its
+   // index in each, so it can be taken out without searching
+   TargetList       *targetlists[2] = { nullptr, nullptr };
+   int               targetindex[2] = { 0, 0 };
+
+   // Links in the entity list of our class id (see G_FindClass)
+   ClassDef         *classentities = nullptr;
+   int               classnext = -1;
+   int               classprev = -1;
+
    // Character state
    float             health;
    float             max_health;
@@ -968,6 +981,7 @@ inline EXPORT_FROM_DLL void Entity::Unarchive(Archiver &arc)
    arc.ReadVector(&absmax);
    arc.ReadVector(&size);
    arc.ReadVector(&centroid);
+   G_SpatialLink(this);
    arc.ReadVector(&origin);
    arc.ReadVector(&velocity);
    arc.ReadVector(&avelocity);
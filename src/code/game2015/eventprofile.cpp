@@ -0,0 +1,363 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Per event and per class dispatch profiler.  Listener::ProcessEvent times
+// every response it calls while g_profileevents is set and hands the result
+// to G_ProfileEvent.  Times are inclusive, so an event that processes other
+// events is charged for them as well.
+// 
+
+#include "g_local.h"
+#include "listener.h"
+#include "eventprofile.h"
+
+cvar_t *g_profileevents;
+
+static evprofile_t      *eventProfiles;
+static int               numEventProfiles;
+static evprofile_t      *classProfiles;     // indexed by classnum
+static int               numClassProfiles;
+static long long         profileStart;
+
+/*
+===============
+G_ProfileBucket
+
+Returns the histogram bucket for a time in nanoseconds.
+===============
+*/
+static int G_ProfileBucket(long long time)
+{
+   int bucket;
+
+   time /= 1000;
+   for(bucket = 0; time && (bucket < EVPROF_BUCKETS - 1); bucket++)
+   {
+      time >>= 1;
+   }
+
+   return bucket;
+}
+
+static void G_AddProfileTime(evprofile_t *prof, long long time)
+{
+   prof->count++;
+   prof->totaltime += time;
+   if(time > prof->maxtime)
+   {
+      prof->maxtime = time;
+   }
+   prof->histogram[G_ProfileBucket(time)]++;
+}
+
+/*
+===============
+G_GrowProfiles
+
+Makes sure there's a profile for index in the list, which is grown to at
+least minsize.  Events and classes can both be registered after the profile
+was started.
+===============
+*/
+static evprofile_t *G_GrowProfiles(evprofile_t **list, int *num, int index, int minsize)
+{
+   evprofile_t *old;
+   int          size;
+
+   if(index >= *num)
+   {
+      size = (minsize > index) ? minsize : index + 1;
+
+      old = *list;
+      *list = new evprofile_t[size];
+      memset(*list, 0, size * sizeof(evprofile_t));
+      if(old)
+      {
+         memcpy(*list, old, *num * sizeof(evprofile_t));
+         delete[] old;
+      }
+      *num = size;
+   }
+
+   return &(*list)[index];
+}
+
+/*
+===============
+G_ProfileEvent
+
+Records one dispatch of eventnum to an object of class cls that took time
+nanoseconds.
+===============
+*/
+EXPORT_FROM_DLL void G_ProfileEvent(int eventnum, const ClassDef *cls, long long time)
+{
+   G_AddProfileTime(G_GrowProfiles(&eventProfiles, &numEventProfiles, eventnum, Event::NumEventCommands()), time);
+
+   // classes only have a number once the class index is built
+   if(cls->classnum >= 0)
+   {
+      G_AddProfileTime(G_GrowProfiles(&classProfiles, &numClassProfiles, cls->classnum, numClasses()), time);
+   }
+}
+
+EXPORT_FROM_DLL void G_ResetEventProfile(void)
+{
+   if(eventProfiles)
+   {
+      memset(eventProfiles, 0, numEventProfiles * sizeof(evprofile_t));
+   }
+
+   if(classProfiles)
+   {
+      memset(classProfiles, 0, numClassProfiles * sizeof(evprofile_t));
+   }
+
+   profileStart = G_Nanoseconds();
+}
+
+EXPORT_FROM_DLL void G_InitEventProfile(void)
+{
+   g_profileevents = gi.cvar("g_profileevents", "0", 0);
+
+   G_ResetEventProfile();
+}
+
+static const evprofile_t *sortProfiles;
+
+static int G_CompareProfileTime(const void *arg1, const void *arg2)
+{
+   const evprofile_t *p1 = &sortProfiles[*(const int *)arg1];
+   const evprofile_t *p2 = &sortProfiles[*(const int *)arg2];
+
+   if(p1->totaltime != p2->totaltime)
+   {
+      return (p1->totaltime < p2->totaltime) ? 1 : -1;
+   }
+
+   return *(const int *)arg1 - *(const int *)arg2;
+}
+
+/*
+===============
+G_SortEventProfile
+
+Returns the events that have been dispatched at least once, most expensive
+first.  The caller frees the list.
+===============
+*/
+static int *G_SortEventProfile(int *count)
+{
+   int *order;
+   int  i;
+
+   order = new int[numEventProfiles + 1];
+   *count = 0;
+   for(i = 1; i < numEventProfiles; i++)
+   {
+      if(eventProfiles[i].count)
+      {
+         order[(*count)++] = i;
+      }
+   }
+
+   sortProfiles = eventProfiles;
+   qsort(order, *count, sizeof(int), G_CompareProfileTime);
+
+   return order;
+}
+
+static int G_CompareClassTime(const void *arg1, const void *arg2)
+{
+   const evprofile_t *p1 = &classProfiles[*(const int *)arg1];
+   const evprofile_t *p2 = &classProfiles[*(const int *)arg2];
+
+   if(p1->totaltime != p2->totaltime)
+   {
+      return (p1->totaltime < p2->totaltime) ? 1 : -1;
+   }
+
+   return strcmp(getClassForNum(*(const int *)arg1)->classname, getClassForNum(*(const int *)arg2)->classname);
+}
+
+static int *G_SortClassProfile(int *count)
+{
+   int *order;
+   int  i;
+
+   order = new int[numClassProfiles + 1];
+   *count = 0;
+   for(i = 0; i < numClassProfiles; i++)
+   {
+      if(classProfiles[i].count && getClassForNum(i))
+      {
+         order[(*count)++] = i;
+      }
+   }
+
+   qsort(order, *count, sizeof(int), G_CompareClassTime);
+
+   return order;
+}
+
+static float G_ProfileMsec(long long time)
+{
+   return (float)((double)time / 1000000.0);
+}
+
+/*
+===============
+G_PrintEventProfile
+
+Prints the num most expensive events and classes.
+===============
+*/
+EXPORT_FROM_DLL void G_PrintEventProfile(int num)
+{
+   const evprofile_t *prof;
+   int               *order;
+   int                count;
+   int                i;
+
+   if(!g_profileevents->value)
+   {
+      gi.printf("Event profiling is off.  Set g_profileevents 1 to turn it on.\n");
+   }
+
+   gi.printf("Profile covers %.2f seconds\n", G_ProfileMsec(G_Nanoseconds() - profileStart) / 1000.0f);
+
+   order = G_SortEventProfile(&count);
+   gi.printf("\n%-32s %9s %10s %9s %9s\n", "event", "count", "total ms", "avg us", "max us");
+   for(i = 0; (i < count) && (i < num); i++)
+   {
+      prof = &eventProfiles[order[i]];
+      gi.printf("%-32s %9d %10.2f %9.2f %9.2f\n", Event::EventName(order[i]), prof->count,
+                G_ProfileMsec(prof->totaltime), (float)((double)prof->totaltime / prof->count / 1000.0),
+                (float)((double)prof->maxtime / 1000.0));
+   }
+   delete[] order;
+
+   order = G_SortClassProfile(&count);
+   gi.printf("\n%-32s %9s %10s %9s %9s\n", "class", "count", "total ms", "avg us", "max us");
+   for(i = 0; (i < count) && (i < num); i++)
+   {
+      prof = &classProfiles[order[i]];
+      gi.printf("%-32s %9d %10.2f %9.2f %9.2f\n", getClassForNum(order[i])->classname, prof->count,
+                G_ProfileMsec(prof->totaltime), (float)((double)prof->totaltime / prof->count / 1000.0),
+                (float)((double)prof->maxtime / 1000.0));
+   }
+   delete[] order;
+}
+
+static void G_WriteProfileCSV(FILE *f, const char *kind, const char *name, const evprofile_t *prof)
+{
+   int i;
+
+   fprintf(f, "%s,%s,%d,%lld,%lld", kind, name, prof->count, prof->totaltime, prof->maxtime);
+   for(i = 0; i < EVPROF_BUCKETS; i++)
+   {
+      fprintf(f, ",%d", prof->histogram[i]);
+   }
+   fprintf(f, "\n");
+}
+
+static void G_WriteProfileJSON(FILE *f, const char *name, const evprofile_t *prof, qboolean last)
+{
+   int i;
+
+   fprintf(f, "    { \"name\": \"%s\", \"count\": %d, \"total_ns\": %lld, \"max_ns\": %lld, \"histogram\": [",
+           name, prof->count, prof->totaltime, prof->maxtime);
+   for(i = 0; i < EVPROF_BUCKETS; i++)
+   {
+      fprintf(f, i ? ", %d" : "%d", prof->histogram[i]);
+   }
+   fprintf(f, "] }%s\n", last ? "" : ",");
+}
+
+/*
+===============
+G_WriteEventProfile
+
+Writes every event and class that has been profiled as CSV or JSON.  Times
+are in nanoseconds.
+===============
+*/
+EXPORT_FROM_DLL void G_WriteEventProfile(const char *filename, qboolean json)
+{
+   FILE *f;
+   int  *order;
+   int   count;
+   int   i;
+
+   gi.CreatePath(filename);
+   f = fopen(filename, "wt");
+   if(!f)
+   {
+      gi.printf("Couldn't open %s\n", filename);
+      return;
+   }
+
+   if(json)
+   {
+      fprintf(f, "{\n  \"duration_ns\": %lld,\n  \"bucket_us\": \"0, 1, 2, 4 ... 16384+\",\n  \"events\": [\n",
+              G_Nanoseconds() - profileStart);
+   }
+   else
+   {
+      fprintf(f, "type,name,count,total_ns,max_ns");
+      for(i = 0; i < EVPROF_BUCKETS; i++)
+      {
+         fprintf(f, ",bucket%d", i);
+      }
+      fprintf(f, "\n");
+   }
+
+   order = G_SortEventProfile(&count);
+   for(i = 0; i < count; i++)
+   {
+      if(json)
+      {
+         G_WriteProfileJSON(f, Event::EventName(order[i]), &eventProfiles[order[i]], i == count - 1);
+      }
+      else
+      {
+         G_WriteProfileCSV(f, "event", Event::EventName(order[i]), &eventProfiles[order[i]]);
+      }
+   }
+   delete[] order;
+
+   if(json)
+   {
+      fprintf(f, "  ],\n  \"classes\": [\n");
+   }
+
+   order = G_SortClassProfile(&count);
+   for(i = 0; i < count; i++)
+   {
+      if(json)
+      {
+         G_WriteProfileJSON(f, getClassForNum(order[i])->classname, &classProfiles[order[i]], i == count - 1);
+      }
+      else
+      {
+         G_WriteProfileCSV(f, "class", getClassForNum(order[i])->classname, &classProfiles[order[i]]);
+      }
+   }
+   delete[] order;
+
+   if(json)
+   {
+      fprintf(f, "  ]\n}\n");
+   }
+
+   fclose(f);
+
+   gi.printf("Wrote event profile to %s\n", filename);
+}
+
+// EOF
@@ -0,0 +1,41 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Per event and per class dispatch profiler.  Enabled with g_profileevents
+// and dumped with "sv eventprofile".
+// 
+
+#ifndef __EVENTPROFILE_H__
+#define __EVENTPROFILE_H__
+
+#include "g_local.h"
+#include "class.h"
+
+// histogram bucket 0 is under a microsecond, bucket n covers 2^(n-1) to 2^n
+// microseconds and the last bucket takes everything above that
+#define EVPROF_BUCKETS 16
+
+typedef struct evprofile_s
+{
+   int         count;
+   long long   totaltime;
+   long long   maxtime;
+   int         histogram[EVPROF_BUCKETS];
+} evprofile_t;
+
+extern cvar_t *g_profileevents;
+
+EXPORT_FROM_DLL void G_InitEventProfile(void);
+EXPORT_FROM_DLL void G_ResetEventProfile(void);
+EXPORT_FROM_DLL void G_ProfileEvent(int eventnum, const ClassDef *cls, long long time);
+EXPORT_FROM_DLL void G_PrintEventProfile(int num);
+EXPORT_FROM_DLL void G_WriteEventProfile(const char *filename, qboolean json);
+
+#endif /* eventprofile.h */
+
+// EOF
@@ -0,0 +1,406 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Binary event trace.  Listener::ProcessEvent fills in a fixed size record
+// for every event it dispatches and drops it into a ring buffer.  A writer
+// thread empties the ring into the trace file, so the game thread never
+// formats text or waits on the disk.  The game thread is the only producer
+// and the writer the only consumer, so the ring only needs the two indices
+// to be atomic.
+//
+// Strings (class names, targetnames and script names) are written once, the
+// first time they're seen, and referred to by number after that.
+// 
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "g_local.h"
+#include "../elib/qstringmap.h"
+#include "scriptmaster.h"
+#include "scriptvariable.h"
+#include "evtrace.h"
+
+// must be a power of 2
+#define EVTRACE_RECORDS    16384
+#define EVTRACE_MAXSTRINGS 65536
+
+typedef struct
+{
+   int         num;
+   char       *text;
+} evtracestring_t;
+
+static auto traceStringKeyFunc = [] (evtracestring_t *ts) { return ts->text; };
+
+class TraceStringMap : public qstringmap<evtracestring_t *, decltype(traceStringKeyFunc)>
+{
+public:
+   using qstringmap::qstringmap;
+};
+
+qboolean EventTracing = false;
+
+static evtrecord_t            traceRing[EVTRACE_RECORDS];
+static std::atomic<unsigned>  traceHead;
+static std::atomic<unsigned>  traceTail;
+static std::atomic<bool>      traceStop;
+static std::thread            traceThread;
+static FILE                  *traceFile;
+static str                    traceFilename;
+
+static long long              traceStart;
+static int                    traceEvents;
+static int                    traceDropped;
+static int                    traceEventNames;
+
+static TraceStringMap         *traceStrings;
+static int                    numTraceStrings;
+
+/*
+===============
+G_TraceWriter
+
+Runs on its own thread while a trace is active.
+===============
+*/
+static void G_TraceWriter(void)
+{
+   unsigned head;
+   unsigned tail;
+   unsigned start;
+   unsigned count;
+
+   for(;;)
+   {
+      tail = traceTail.load(std::memory_order_relaxed);
+      head = traceHead.load(std::memory_order_acquire);
+
+      if(head == tail)
+      {
+         if(traceStop.load())
+         {
+            break;
+         }
+
+         std::this_thread::sleep_for(std::chrono::milliseconds(2));
+         continue;
+      }
+
+      // write up to the end of the ring and pick up the rest next time around
+      start = tail & (EVTRACE_RECORDS - 1);
+      count = head - tail;
+      if(count > EVTRACE_RECORDS - start)
+      {
+         count = EVTRACE_RECORDS - start;
+      }
+
+      fwrite(&traceRing[start], sizeof(evtrecord_t), count, traceFile);
+      traceTail.store(tail + count, std::memory_order_release);
+   }
+
+   fflush(traceFile);
+}
+
+/*
+===============
+G_TraceAlloc
+
+Returns the next free record in the ring.  Events are dropped when the
+writer falls behind, but string definitions have to get through or the rest
+of the file can't be decoded, so those wait for room.
+===============
+*/
+static evtrecord_t *G_TraceAlloc(qboolean wait)
+{
+   unsigned head;
+
+   head = traceHead.load(std::memory_order_relaxed);
+   while((head - traceTail.load(std::memory_order_acquire)) >= EVTRACE_RECORDS)
+   {
+      if(!wait)
+      {
+         traceDropped++;
+         return nullptr;
+      }
+
+      std::this_thread::yield();
+   }
+
+   return &traceRing[head & (EVTRACE_RECORDS - 1)];
+}
+
+static void G_TraceCommit(void)
+{
+   traceHead.store(traceHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+static void G_TraceName(int type, int num, const char *text)
+{
+   evtrecord_t *rec;
+   int          len;
+   int          i;
+
+   len = strlen(text);
+   if(len > 0xffff)
+   {
+      len = 0xffff;
+   }
+
+   rec = G_TraceAlloc(true);
+   memset(rec, 0, sizeof(*rec));
+   rec->type = type;
+   rec->eventnum = num;
+   rec->numargs = len;
+   G_TraceCommit();
+
+   for(i = 0; i < len; i += sizeof(evtrecord_t))
+   {
+      rec = G_TraceAlloc(true);
+      memset(rec, 0, sizeof(*rec));
+      memcpy(rec, text + i, ((len - i) < (int)sizeof(evtrecord_t)) ? (len - i) : sizeof(evtrecord_t));
+      G_TraceCommit();
+   }
+}
+
+/*
+===============
+G_TraceEventNames
+
+Writes the names of any events registered since the last time this was
+called.
+===============
+*/
+static void G_TraceEventNames(void)
+{
+   int num;
+
+   num = Event::NumEventCommands();
+   for(; traceEventNames < num; traceEventNames++)
+   {
+      G_TraceName(EVTREC_EVENTNAME, traceEventNames, Event::EventName(traceEventNames));
+   }
+}
+
+/*
+===============
+G_TraceString
+
+Returns the number of a string in the trace, writing it out the first time.
+===============
+*/
+static int G_TraceString(const char *text)
+{
+   evtracestring_t *ts;
+
+   if(!text || !*text)
+   {
+      return 0;
+   }
+
+   if(!traceStrings)
+   {
+      traceStrings = new TraceStringMap(traceStringKeyFunc);
+   }
+
+   ts = traceStrings->find(text);
+   if(ts)
+   {
+      return ts->num;
+   }
+
+   if(numTraceStrings + 1 >= EVTRACE_MAXSTRINGS)
+   {
+      return 0;
+   }
+
+   numTraceStrings++;
+   ts = new evtracestring_t;
+   ts->num = numTraceStrings;
+   ts->text = new char[strlen(text) + 1];
+   strcpy(ts->text, text);
+   traceStrings->insert(ts);
+
+   G_TraceName(EVTREC_STRING, numTraceStrings, text);
+
+   return numTraceStrings;
+}
+
+static void G_FreeTraceStrings(void)
+{
+   if(traceStrings)
+   {
+      for(auto &itr : traceStrings->tmap)
+      {
+         delete[] itr.second->text;
+         delete itr.second;
+      }
+
+      delete traceStrings;
+      traceStrings = nullptr;
+   }
+
+   numTraceStrings = 0;
+}
+
+/*
+===============
+G_TraceEvent
+
+Called from Listener::ProcessEvent for every event while tracing.
+===============
+*/
+EXPORT_FROM_DLL void G_TraceEvent(Listener *obj, Event *event)
+{
+   evtrecord_t  *rec;
+   ScriptThread *thread;
+   int           ev;
+   int           classname;
+   int           label;
+   int           filename;
+   int           object;
+   int           entnum;
+   int           threadnum;
+
+   ev = (int)*event;
+   if(ev >= traceEventNames)
+   {
+      G_TraceEventNames();
+   }
+
+   classname = G_TraceString(obj->getClassname());
+   label = 0;
+   filename = 0;
+   entnum = -1;
+   threadnum = -1;
+   object = EVTOBJ_OTHER;
+
+   if(obj->isSubclassOf<Entity>())
+   {
+      object = EVTOBJ_ENTITY;
+      entnum = ((Entity *)obj)->entnum;
+      if(((Entity *)obj)->Targeted())
+      {
+         label = G_TraceString(((Entity *)obj)->TargetName());
+      }
+   }
+   else if(obj->isSubclassOf<ScriptThread>())
+   {
+      object = EVTOBJ_THREAD;
+      threadnum = ((ScriptThread *)obj)->ThreadNum();
+      label = G_TraceString(((ScriptThread *)obj)->ThreadName());
+   }
+   else if(obj->isSubclassOf<ScriptVariable>())
+   {
+      object = EVTOBJ_VARIABLE;
+      label = G_TraceString(((ScriptVariable *)obj)->getName());
+   }
+
+   if(event->GetSource() == EV_FROM_SCRIPT)
+   {
+      thread = event->GetThread();
+      filename = G_TraceString(thread ? thread->Filename() : "Dead script");
+   }
+
+   rec = G_TraceAlloc(false);
+   if(!rec)
+   {
+      return;
+   }
+
+   rec->timestamp = G_Nanoseconds() - traceStart;
+   rec->framenum = level.framenum;
+   rec->time = level.time;
+   rec->eventnum = ev;
+   rec->threadnum = threadnum;
+   rec->linenumber = event->GetLineNumber();
+   rec->argdigest = event->ArgDigest();
+   rec->entnum = entnum;
+   rec->classname = classname;
+   rec->label = label;
+   rec->filename = filename;
+   rec->numargs = event->NumArgs();
+   rec->type = EVTREC_EVENT;
+   rec->source = event->GetSource();
+   rec->object = object;
+   rec->pad[0] = rec->pad[1] = rec->pad[2] = 0;
+
+   G_TraceCommit();
+   traceEvents++;
+}
+
+EXPORT_FROM_DLL void G_StartEventTrace(const char *filename)
+{
+   evtraceheader_t header;
+
+   G_StopEventTrace();
+
+   gi.CreatePath(filename);
+   traceFile = fopen(filename, "wb");
+   if(!traceFile)
+   {
+      gi.printf("Couldn't open %s\n", filename);
+      return;
+   }
+
+   header.ident = EVTRACE_IDENT;
+   header.version = EVTRACE_VERSION;
+   header.recordsize = sizeof(evtrecord_t);
+   header.reserved = 0;
+   fwrite(&header, sizeof(header), 1, traceFile);
+
+   traceFilename = filename;
+   traceHead = 0;
+   traceTail = 0;
+   traceStop = false;
+   traceStart = G_Nanoseconds();
+   traceEvents = 0;
+   traceDropped = 0;
+   traceEventNames = 1;
+
+   traceThread = std::thread(G_TraceWriter);
+   EventTracing = true;
+
+   G_TraceEventNames();
+
+   gi.printf("Tracing events to %s\n", filename);
+}
+
+EXPORT_FROM_DLL void G_StopEventTrace(void)
+{
+   if(!EventTracing)
+   {
+      return;
+   }
+
+   EventTracing = false;
+   traceStop = true;
+   traceThread.join();
+
+   fclose(traceFile);
+   traceFile = nullptr;
+
+   G_FreeTraceStrings();
+
+   gi.printf("Wrote %d events to %s (%d dropped)\n", traceEvents, traceFilename.c_str(), traceDropped);
+}
+
+EXPORT_FROM_DLL void G_EventTraceInfo(void)
+{
+   if(!EventTracing)
+   {
+      gi.printf("Not tracing events.\n");
+      return;
+   }
+
+   gi.printf("Tracing to %s\n", traceFilename.c_str());
+   gi.printf("%d events, %d dropped, %d strings, %d records waiting\n", traceEvents, traceDropped, numTraceStrings,
+             (int)(traceHead.load() - traceTail.load()));
+}
+
+// EOF
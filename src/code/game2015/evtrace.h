@@ -0,0 +1,29 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Binary event trace.  A cheap replacement for g_showevents that can be left
+// running on a loaded server.  Decode the files with tools/evtrace.
+// 
+
+#ifndef __EVTRACE_H__
+#define __EVTRACE_H__
+
+#include "g_local.h"
+#include "listener.h"
+#include "evtracefile.h"
+
+extern qboolean EventTracing;
+
+EXPORT_FROM_DLL void G_StartEventTrace(const char *filename);
+EXPORT_FROM_DLL void G_StopEventTrace(void);
+EXPORT_FROM_DLL void G_TraceEvent(Listener *obj, Event *event);
+EXPORT_FROM_DLL void G_EventTraceInfo(void);
+
+#endif /* evtrace.h */
+
+// EOF
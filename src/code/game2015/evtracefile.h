@@ -0,0 +1,64 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Layout of the binary event trace files written by "sv eventtrace".  This
+// header is shared with the decoder in tools/evtrace, so it must not depend
+// on anything else in the game.
+// 
+
+#ifndef __EVTRACEFILE_H__
+#define __EVTRACEFILE_H__
+
+#define EVTRACE_IDENT     (('R' << 24) + ('T' << 16) + ('V' << 8) + 'E')
+#define EVTRACE_VERSION   1
+
+typedef struct evtraceheader_s
+{
+   int            ident;
+   int            version;
+   int            recordsize;
+   int            reserved;
+} evtraceheader_t;
+
+// record types
+#define EVTREC_EVENT       0  // an event was dispatched
+#define EVTREC_STRING      1  // defines string number 'eventnum', 'numargs' characters follow
+#define EVTREC_EVENTNAME   2  // defines the name of event 'eventnum', 'numargs' characters follow
+
+// what kind of object received the event
+#define EVTOBJ_OTHER       0
+#define EVTOBJ_ENTITY      1
+#define EVTOBJ_THREAD      2
+#define EVTOBJ_VARIABLE    3
+
+// Every record is the same size.  The characters of a string or event name
+// are stored in the records that follow its definition, padded out to a
+// whole record.  String 0 is always the empty string.
+typedef struct evtrecord_s
+{
+   long long      timestamp;     // nanoseconds since the trace started
+   int            framenum;
+   float          time;
+   int            eventnum;
+   int            threadnum;     // number of the thread that received the event
+   int            linenumber;    // script line, or client number for console events
+   unsigned int   argdigest;
+   short          entnum;
+   unsigned short classname;
+   unsigned short label;         // targetname, thread name or variable name
+   unsigned short filename;      // script that sent the event
+   unsigned short numargs;
+   unsigned char  type;
+   unsigned char  source;        // eventsource_t
+   unsigned char  object;
+   unsigned char  pad[3];
+} evtrecord_t;
+
+#endif /* evtracefile.h */
+
+// EOF
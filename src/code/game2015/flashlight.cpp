@@ -80,7 +80,7 @@ void Flashlight::Use(Event *ev)
    {
       if(lighton < 0)
          lighton *= -1;
-      PostEvent(EV_Flashlight_EmitLight, 0.1);
+      Schedule(EV_Flashlight_EmitLight, 0.1);
       owner->sound("environment/switch/smallsw1.wav", 1, CHAN_ITEM, ATTN_NORM);
    }
 }
@@ -128,6 +128,7 @@ void Flashlight::EmitLight(Event *ev)
                lightent2 = nullptr;
             }
 
+            CancelEventsOfType(EV_Flashlight_EmitLight);
             owner->RemoveItem(this);
             return;
          }
@@ -243,8 +244,6 @@ void Flashlight::EmitLight(Event *ev)
       lightent2->edict->s.color_g = 0.35;
       lightent2->setOrigin(trace.endpos);
    }
-
-   PostEvent(EV_Flashlight_EmitLight, 0.1);
 }
 
 void Flashlight::Pickup(Event * ev)
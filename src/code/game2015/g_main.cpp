@@ -14,7 +14,7 @@
 // 
 
 //### upped savegame version for the add-on pack
-#define SAVEGAME_VERSION 17
+#define SAVEGAME_VERSION 18
 
 #include <setjmp.h>
 #include "limits.h"
@@ -32,6 +32,9 @@
 #include "deadbody.h"
 #include "spritegun.h" //### added for sprite gun
 #include "ctf.h"
+#include "eventprofile.h"
+#include "scriptprofile.h"
+#include "evtrace.h"
 
 Vector vec_origin(0, 0, 0);
 Vector vec_zero(0, 0, 0);
@@ -77,6 +80,7 @@ cvar_t	*dm_respawn;
 cvar_t   *dialog;
 cvar_t	*precache;
 cvar_t   *g_showmem;
+cvar_t   *g_scriptcache;
 cvar_t   *g_timeents;
 cvar_t	*noreload;
 
@@ -210,6 +214,7 @@ void G_ShutdownGame(void)
       G_ExitWithError();
    }
 
+   G_StopEventTrace();
    G_LevelShutdown();
    CleanupSpriteGun();    //###
    gi.FreeTags(TAG_GAME);
@@ -306,6 +311,7 @@ void G_InitGame(void)
    g_select_empty		= gi.cvar("g_select_empty", "0", CVAR_ARCHIVE);
    g_unlimited_ammo	= gi.cvar("g_unlimited_ammo", "0", CVAR_SERVERINFO);
    g_showmem         = gi.cvar("g_showmem", "0", 0);
+   g_scriptcache     = gi.cvar("g_scriptcache", "1", 0);
    g_timeents        = gi.cvar("g_timeents", "0", 0);
    dm_respawn			= gi.cvar("dm_respawn", "2", CVAR_SERVERINFO);
    nomonsters			= gi.cvar("nomonsters", "0", CVAR_SERVERINFO);
@@ -362,6 +368,7 @@ void G_InitGame(void)
    CTF_Init();
 
    G_InitEvents();
+   G_InitScriptProfile();
    sv_numtraces = 0;
 
    game.maxentities = maxentities->value;
@@ -394,6 +401,8 @@ void G_AllocGameData(void)
    g_edicts =  (edict_t *)gi.TagMalloc(game.maxentities * sizeof(g_edicts[0]), TAG_GAME);
    globals.edicts = g_edicts;
    globals.max_edicts = game.maxentities;
+   G_InitSpatialHash();
+   G_ResetClassEntities();
 
    // Add all the edicts to the free list
    LL_Reset(&free_edicts, next, prev);
@@ -785,6 +794,9 @@ void ReadLevel(const char *filename)
 
    arc.Close();
 
+   // now that the object pointers are fixed up, give the pending events to their objects
+   G_LinkPendingEvents();
+
    // call the precache scripts
    G_Precache();
 
@@ -1390,6 +1402,10 @@ void G_RunFrame(void)
    if(g_showmem->value)
    {
       DisplayMemoryUsage();
+      if((g_showmem->value >= 2) && !(level.framenum % 10))
+      {
+         DisplayClassMemoryUsage(10);
+      }
    }
 
    // exit intermissions
@@ -3402,6 +3418,150 @@ void SVCmd_Reset_f(void)
 }
 //###
 
+/*
+=================
+SVCmd_EventProfile_f
+
+sv eventprofile [reset | print [count] | csv [filename] | json [filename]]
+=================
+*/
+void SVCmd_EventProfile_f(void)
+{
+   char       name[MAX_OSPATH];
+   const char *cmd;
+   cvar_t     *game;
+   qboolean   json;
+
+   cmd = (gi.argc() > 2) ? gi.argv(2) : "print";
+
+   if(Q_stricmp(cmd, "reset") == 0)
+   {
+      G_ResetEventProfile();
+   }
+   else if(Q_stricmp(cmd, "print") == 0)
+   {
+      G_PrintEventProfile((gi.argc() > 3) ? atoi(gi.argv(3)) : 20);
+   }
+   else if((Q_stricmp(cmd, "csv") == 0) || (Q_stricmp(cmd, "json") == 0))
+   {
+      json = (Q_stricmp(cmd, "json") == 0);
+      game = gi.cvar("game", "", 0);
+
+      if(gi.argc() > 3)
+      {
+         snprintf(name, sizeof(name), "%s/%s", *game->string ? game->string : GAMEVERSION, gi.argv(3));
+      }
+      else
+      {
+         snprintf(name, sizeof(name), "%s/eventprofile.%s", *game->string ? game->string : GAMEVERSION, json ? "json" : "csv");
+      }
+
+      G_WriteEventProfile(name, json);
+   }
+   else
+   {
+      gi.printf("Usage: sv eventprofile [reset | print [count] | csv [filename] | json [filename]]\n");
+   }
+}
+
+/*
+=================
+SVCmd_ScriptProfile_f
+
+sv scriptprofile [reset | print [count]]
+=================
+*/
+void SVCmd_ScriptProfile_f(void)
+{
+   const char *cmd;
+
+   cmd = (gi.argc() > 2) ? gi.argv(2) : "print";
+
+   if(Q_stricmp(cmd, "reset") == 0)
+   {
+      G_ResetScriptProfile();
+   }
+   else if(Q_stricmp(cmd, "print") == 0)
+   {
+      G_PrintScriptProfile((gi.argc() > 3) ? atoi(gi.argv(3)) : 20);
+   }
+   else
+   {
+      gi.printf("Usage: sv scriptprofile [reset | print [count]]\n");
+   }
+}
+
+/*
+=================
+SVCmd_EventTrace_f
+
+sv eventtrace [start [filename] | stop | info]
+=================
+*/
+void SVCmd_EventTrace_f(void)
+{
+   char       name[MAX_OSPATH];
+   const char *cmd;
+   cvar_t     *game;
+
+   cmd = (gi.argc() > 2) ? gi.argv(2) : "info";
+
+   if(Q_stricmp(cmd, "start") == 0)
+   {
+      game = gi.cvar("game", "", 0);
+
+      if(gi.argc() > 3)
+      {
+         snprintf(name, sizeof(name), "%s/%s", *game->string ? game->string : GAMEVERSION, gi.argv(3));
+      }
+      else
+      {
+         snprintf(name, sizeof(name), "%s/events.evt", *game->string ? game->string : GAMEVERSION);
+      }
+
+      G_StartEventTrace(name);
+   }
+   else if(Q_stricmp(cmd, "stop") == 0)
+   {
+      G_StopEventTrace();
+   }
+   else if(Q_stricmp(cmd, "info") == 0)
+   {
+      G_EventTraceInfo();
+   }
+   else
+   {
+      gi.printf("Usage: sv eventtrace [start [filename] | stop | info]\n");
+   }
+}
+
+/*
+=================
+SVCmd_EventBench_f
+
+sv eventbench [count] [count] ...
+Times the event queue against the old sorted event list.  The list is only
+timed up to 10000 events since it takes minutes beyond that.
+=================
+*/
+void SVCmd_EventBench_f(void)
+{
+   int i;
+
+   if(gi.argc() < 3)
+   {
+      G_EventQueueBenchmark(1000);
+      G_EventQueueBenchmark(10000);
+      G_EventQueueBenchmark(100000);
+      return;
+   }
+
+   for(i = 2; i < gi.argc(); i++)
+   {
+      G_EventQueueBenchmark(atoi(gi.argv(i)));
+   }
+}
+
 /*
 =================
 G_ServerCommand
@@ -3438,6 +3598,38 @@ void G_ServerCommand(void)
       SVCmd_Reset_f();
    }
    //###
+   else if(Q_stricmp(cmd, "eventbench") == 0)
+   {
+      SVCmd_EventBench_f();
+   }
+   else if(Q_stricmp(cmd, "eventstats") == 0)
+   {
+      Event::PrintAllocStats();
+   }
+   else if(Q_stricmp(cmd, "eventpool") == 0)
+   {
+      G_EventPoolInfo();
+   }
+   else if(Q_stricmp(cmd, "eventprofile") == 0)
+   {
+      SVCmd_EventProfile_f();
+   }
+   else if(Q_stricmp(cmd, "eventtrace") == 0)
+   {
+      SVCmd_EventTrace_f();
+   }
+   else if(Q_stricmp(cmd, "scriptprofile") == 0)
+   {
+      SVCmd_ScriptProfile_f();
+   }
+   else if(Q_stricmp(cmd, "classbench") == 0)
+   {
+      ClassInheritanceBenchmark((gi.argc() > 2) ? atoi(gi.argv(2)) : 100000);
+   }
+   else if(Q_stricmp(cmd, "classmem") == 0)
+   {
+      DisplayClassMemoryUsage((gi.argc() > 2) ? atoi(gi.argv(2)) : 20);
+   }
    else
    {
       gi.cprintf(NULL, PRINT_HIGH, "Unknown server command \"%s\"\n", cmd);
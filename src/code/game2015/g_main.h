@@ -154,6 +154,9 @@ void        SVCmd_AddIP_f(void);
 void        SVCmd_RemoveIP_f(void);
 void        SVCmd_ListIP_f(void);
 void        SVCmd_WriteIP_f(void);
+void        SVCmd_EventBench_f(void);
+void        SVCmd_EventProfile_f(void);
+void        SVCmd_EventTrace_f(void);
 
 void        G_InitSoundtrack(void);
 
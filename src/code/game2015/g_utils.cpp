@@ -18,7 +18,10 @@
 #include "ctype.h"
 #include "worldspawn.h"
 #include "scriptmaster.h"
+#include "spatialhash.h"
+#ifdef _WIN32
 #include "windows.h"
+#endif
 #include "ctf.h"
 
 cvar_t *g_numdebuglines;
@@ -347,10 +350,9 @@ Entity *SelectRandomDeathmatchSpawnPoint(void)
    range1 = range2 = 99999;
    spot1 = spot2 = NULL;
 
-   num = 0;
-   while((num = G_FindClass(num, "info_player_deathmatch")) != 0)
+   for(Entity *ent : G_ClassEntities("info_player_deathmatch"))
    {
-      spot = G_GetEntity(num);
+      spot = ent;
       count++;
       range = PlayersRangeFromSpot(spot);
       if(range < range1)
@@ -414,10 +416,9 @@ Entity *SelectFarthestDeathmatchSpawnPoint(void)
    spot = NULL;
    bestspot = NULL;
    bestdistance = 0;
-   num = 0;
-   while((num = G_FindClass(num, "info_player_deathmatch")) != NULL)
+   for(Entity *ent : G_ClassEntities("info_player_deathmatch"))
    {
-      spot = G_GetEntity(num);
+      spot = ent;
 
       bestplayerdistance = PlayersRangeFromSpot(spot);
       if(bestplayerdistance > bestdistance)
@@ -719,35 +720,200 @@ char *G_CopyString(const char *in)
    return newb;
 }
 
-int G_FindClass(int entnum, const char *classname)
+static inline Entity *G_ClassEntity(int entnum)
 {
-   edict_t *from;
+   return g_edicts[entnum].entity;
+}
 
-   // SINEX_FIXME: efficiency - linear search
-   for(from = &g_edicts[entnum + 1]; from < &g_edicts[globals.num_edicts]; from++)
+/*
+=================
+G_AddClassEntity
+
+Adds ent to the entity list of its class id.  Called from the Entity
+constructor, before the derived classes are constructed, so the class comes
+from the allocation instead of classinfo.
+=================
+*/
+void G_AddClassEntity(Entity *ent)
+{
+   ClassDef *cls;
+   int       prev;
+
+   cls = Class::AllocatedClass(ent)->idclass;
+   if(!cls)
    {
-      if(!from->inuse)
+      return;
+   }
+
+   // new entities usually go at the end, so look from there
+   prev = cls->lastEntity;
+   while((prev >= 0) && (prev > ent->entnum))
+   {
+      prev = G_ClassEntity(prev)->classprev;
+   }
+
+   ent->classentities = cls;
+   ent->classprev = prev;
+   if(prev >= 0)
+   {
+      ent->classnext = G_ClassEntity(prev)->classnext;
+      G_ClassEntity(prev)->classnext = ent->entnum;
+   }
+   else
+   {
+      ent->classnext = cls->firstEntity;
+      cls->firstEntity = ent->entnum;
+   }
+
+   if(ent->classnext >= 0)
+   {
+      G_ClassEntity(ent->classnext)->classprev = ent->entnum;
+   }
+   else
+   {
+      cls->lastEntity = ent->entnum;
+   }
+
+   cls->numEntities++;
+}
+
+/*
+=================
+G_RemoveClassEntity
+
+Entities left over from before G_ResetClassEntities aren't in a list any
+more, so make sure ent is still linked in before unlinking it.
+=================
+*/
+void G_RemoveClassEntity(Entity *ent)
+{
+   ClassDef *cls;
+   Entity   *prev;
+
+   cls = ent->classentities;
+   if(!cls)
+   {
+      return;
+   }
+
+   prev = (ent->classprev >= 0) ? G_ClassEntity(ent->classprev) : nullptr;
+   if(prev ? (prev->classnext == ent->entnum) : (cls->firstEntity == ent->entnum))
+   {
+      if(prev)
       {
-         continue;
+         prev->classnext = ent->classnext;
       }
-      if(!Q_stricmp(from->entity->getClassID(), classname))
+      else
+      {
+         cls->firstEntity = ent->classnext;
+      }
+
+      if(ent->classnext >= 0)
       {
-         return from->s.number;
+         G_ClassEntity(ent->classnext)->classprev = ent->classprev;
       }
+      else
+      {
+         cls->lastEntity = ent->classprev;
+      }
+
+      cls->numEntities--;
    }
 
-   return 0;
+   ent->classentities = nullptr;
+   ent->classnext = -1;
+   ent->classprev = -1;
+}
+
+/*
+=================
+G_ResetClassEntities
+
+Empties every class's entity list.  Called from G_AllocGameData when the
+edicts are thrown out.
+=================
+*/
+void G_ResetClassEntities(void)
+{
+   ClassDef *cls;
+   int       i;
+
+   for(i = 0; i < numClasses(); i++)
+   {
+      cls = const_cast<ClassDef *>(getClassForNum(i));
+      cls->firstEntity = -1;
+      cls->lastEntity = -1;
+      cls->numEntities = 0;
+   }
+}
+
+int G_NextClassEntity(int entnum)
+{
+   return (entnum >= 0) ? G_ClassEntity(entnum)->classnext : -1;
+}
+
+ClassEntityRange G_ClassEntities(const char *classname)
+{
+   const ClassDef *cls;
+
+   cls = getClassForID(classname);
+   return ClassEntityRange(cls ? cls->idclass : nullptr);
+}
+
+/*
+=================
+G_FindClass
+
+Returns the first entity after entnum with the class id, or 0 if there
+aren't any more.  Each step is constant time when entnum is itself one of
+the entities with the class id, as in the usual
+"while((num = G_FindClass(num, classname)))" loop.
+=================
+*/
+int G_FindClass(int entnum, const char *classname)
+{
+   const ClassDef *cls;
+   Entity         *ent;
+   int             num;
+
+   cls = getClassForID(classname);
+   if(!cls || !cls->idclass)
+   {
+      return 0;
+   }
+   cls = cls->idclass;
+
+   ent = g_edicts[entnum].entity;
+   if(ent && (ent->classentities == cls))
+   {
+      num = ent->classnext;
+   }
+   else
+   {
+      for(num = cls->firstEntity; (num >= 0) && (num <= entnum); num = G_ClassEntity(num)->classnext)
+      {
+      }
+   }
+
+   return (num >= 0) ? num : 0;
 }
 
 int G_FindTarget(int entnum, const char *name)
 {
-   edict_t  *from;
-   Entity   *next;
+   edict_t     *from;
+   Entity      *next;
+   TargetList  *tlist;
 
    if(name && name[0])
    {
+      tlist = world->FindTargetList(name);
+      if(!tlist)
+      {
+         return 0;
+      }
+
       from = &g_edicts[entnum];
-      next = world->GetNextEntity(str(name), from->entity);
+      next = tlist->GetNextEntity(from->entity);
       if(next)
       {
          return next->entnum;
@@ -910,13 +1076,22 @@ findradius
 Returns entities that have origins within a spherical area
 
 findradius (origin, radius)
+
+Entities come back in entity number order.  The candidates are taken from
+the spatial hash when the area is small enough, otherwise every edict after
+startent is checked.
 =================
 */
 Entity *findradius(Entity *startent, Vector org, float rad)
 {
    Vector	eorg;
    edict_t	*from;
+   const int *span;
    float		r2;
+   int      num;
+   int      lo;
+   int      hi;
+   int      mid;
 
    if(!startent)
    {
@@ -931,6 +1106,42 @@ Entity *findradius(Entity *startent, Vector org, float rad)
    // square the radius so that we don't have to do a square root
    r2 = rad * rad;
 
+   if(G_SpatialRadiusSpan(org, rad, &span, &num))
+   {
+      // find the first candidate after startent
+      lo = 0;
+      hi = num;
+      while(lo < hi)
+      {
+         mid = (lo + hi) >> 1;
+         if(span[mid] <= startent->entnum)
+         {
+            lo = mid + 1;
+         }
+         else
+         {
+            hi = mid;
+         }
+      }
+
+      for(; lo < num; lo++)
+      {
+         from = &g_edicts[span[lo]];
+         if(!from->inuse || !from->entity)
+         {
+            continue;
+         }
+
+         eorg = org - from->entity->centroid;
+         if((eorg * eorg) <= r2)
+         {
+            return from->entity;
+         }
+      }
+
+      return NULL;
+   }
+
    assert(startent->edict);
    for(from = startent->edict + 1; from < &g_edicts[globals.num_edicts]; from++)
    {
@@ -1843,8 +2054,39 @@ int G_Milliseconds(void)
 
    return timeGetTime() - base;
 #else
-   //FIXME
-   return 0;
+   return (int)(G_Nanoseconds() / 1000000);
+#endif
+}
+
+/*
+================
+G_Nanoseconds
+
+Monotonic high resolution clock for timing code.  Only differences between
+two calls are meaningful.
+================
+*/
+long long G_Nanoseconds(void)
+{
+#ifdef _WIN32
+   static LARGE_INTEGER frequency;
+   LARGE_INTEGER        counter;
+
+   if(!frequency.QuadPart)
+   {
+      QueryPerformanceFrequency(&frequency);
+   }
+
+   QueryPerformanceCounter(&counter);
+
+   // split the conversion so that it doesn't overflow
+   return (counter.QuadPart / frequency.QuadPart) * 1000000000LL +
+      ((counter.QuadPart % frequency.QuadPart) * 1000000000LL) / frequency.QuadPart;
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
 #endif
 }
 
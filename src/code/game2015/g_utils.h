@@ -35,6 +35,47 @@ EXPORT_FROM_DLL char      *G_CopyString(const char *in);
 EXPORT_FROM_DLL int        G_FindClass(int entnum, const char *classname);
 EXPORT_FROM_DLL Entity    *G_NextEntity(Entity *ent);
 
+EXPORT_FROM_DLL void       G_AddClassEntity(Entity *ent);
+EXPORT_FROM_DLL void       G_RemoveClassEntity(Entity *ent);
+EXPORT_FROM_DLL void       G_ResetClassEntities(void);
+EXPORT_FROM_DLL int        G_NextClassEntity(int entnum);
+
+//
+// The live entities with a class id, in entity number order:
+//
+//    for(Entity *spot : G_ClassEntities("info_player_deathmatch"))
+//
+// The entity being visited may be deleted, but not the ones after it.
+//
+class ClassEntityRange
+{
+public:
+   class iterator
+   {
+   public:
+      explicit iterator(int entnum) : entnum(entnum), next(G_NextClassEntity(entnum)) {}
+
+      Entity   *operator * () const { return g_edicts[entnum].entity; }
+      iterator &operator ++ () { entnum = next; next = G_NextClassEntity(entnum); return *this; }
+      bool      operator != (const iterator &other) const { return entnum != other.entnum; }
+
+   private:
+      int entnum;
+      int next;
+   };
+
+   explicit ClassEntityRange(const ClassDef *cls) : cls(cls) {}
+
+   iterator begin() const { return iterator(cls ? cls->firstEntity : -1); }
+   iterator end()   const { return iterator(-1); }
+   int      size()  const { return cls ? cls->numEntities : 0; }
+
+private:
+   const ClassDef *cls;
+};
+
+EXPORT_FROM_DLL ClassEntityRange G_ClassEntities(const char *classname);
+
 EXPORT_FROM_DLL void       G_CalcBoundsOfMove(Vector &start, Vector &end, Vector &mins, Vector &maxs, Vector *minbounds, Vector *maxbounds);
 
 EXPORT_FROM_DLL void       G_ShowTrace(trace_t *trace, edict_t *passent, const char *reason);
@@ -82,6 +123,7 @@ EXPORT_FROM_DLL void G_LoadAndExecScript(const char *filename, const char *label
 EXPORT_FROM_DLL ScriptThread *ExecuteThread(str thread_name, qboolean start = true);
 
 EXPORT_FROM_DLL int  G_Milliseconds(void);
+EXPORT_FROM_DLL long long G_Nanoseconds(void);
 EXPORT_FROM_DLL void G_DebugPrintf(const char *fmt, ...);
 
 //==================================================================
@@ -150,6 +192,23 @@ inline EXPORT_FROM_DLL float G_CRandom(float n)
    return G_CRandom() * n;
 }
 
+//
+// Hashes size bytes of data, carrying on from hash so that several blocks can
+// be hashed together.  Same hash as qstring::HashCodeCaseStatic, which is what
+// strings should use.
+//
+inline EXPORT_FROM_DLL unsigned G_HashData(const void *data, size_t size, unsigned hash = 0)
+{
+   const unsigned char *bytes = (const unsigned char *)data;
+
+   while(size--)
+   {
+      hash = *bytes++ + (hash << 6) + (hash << 16) - hash;
+   }
+
+   return hash;
+}
+
 //
 // Converts all backslashes in a string to forward slashes.
 // Used to make filenames consistant.
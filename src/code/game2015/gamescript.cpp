@@ -17,6 +17,7 @@
 #include "g_local.h"
 #include "script.h"
 #include "gamescript.h"
+#include "scriptmaster.h"
 #include "../elib/qstringmap.h" // haleyjd 20170608
 
 ScriptLibrarian ScriptLib;
@@ -267,6 +268,7 @@ GameScript::~GameScript()
 void GameScript::Close(void)
 {
    FreeLabels();
+   FreeProgram();
    Script::Close();
    sourcescript = this;
    crc = 0;
@@ -311,9 +313,15 @@ void GameScript::LoadFile(const char *name)
 
    sourcescript = this;
    Script::LoadFile(n.c_str());
-   FindLabels();
 
    crc = gi.CalcCRC((const unsigned char*)buffer, length);
+
+   if(!LoadCache())
+   {
+      FindLabels();
+      Compile();
+      WriteCache();
+   }
 }
 
 void GameScript::FindLabels(void)
@@ -381,6 +389,44 @@ EXPORT_FROM_DLL qboolean GameScript::labelExists(const char *name)
    return sourcescript->labelMap->contains(labelname.c_str());
 }
 
+/*
+==============
+GameScript::LabelAtLine
+
+Returns the last label before line, or NULL if the line is above all of
+them.  Labels are kept in the order they're found, so this is the one the
+line would be run under if the script was read from the top.
+==============
+*/
+EXPORT_FROM_DLL const char *GameScript::LabelAtLine(int line)
+{
+   Container<script_label_t *> *labels;
+   script_label_t *label;
+   const char     *name;
+   int             num;
+   int             i;
+
+   labels = sourcescript->labelList;
+   if(!labels)
+   {
+      return nullptr;
+   }
+
+   name = nullptr;
+   num = labels->NumObjects();
+   for(i = 1; i <= num; i++)
+   {
+      label = labels->ObjectAt(i);
+      if(label->pos.line > line)
+      {
+         break;
+      }
+      name = label->labelname.c_str();
+   }
+
+   return name;
+}
+
 EXPORT_FROM_DLL qboolean GameScript::Goto(const char *name)
 {
    if(!sourcescript->labelMap)
@@ -409,6 +455,650 @@ EXPORT_FROM_DLL qboolean GameScript::Goto(const char *name)
       return false;
 }
 
+void GameScript::FreeProgram(void)
+{
+   if(program)
+   {
+      delete[] program->ops;
+      delete[] program->argv;
+      delete[] program->values;
+      delete[] program->strings;
+      delete[] program->hashoffsets;
+      delete[] program->hashops;
+      delete program;
+      program = nullptr;
+   }
+}
+
+void GameScript::AddStatement(int offset, int op)
+{
+   int i;
+
+   for(i = (offset * 2654435761u) & (program->hashsize - 1); program->hashoffsets[i] != -1; i = (i + 1) & (program->hashsize - 1))
+   {
+      if(program->hashoffsets[i] == offset)
+      {
+         return;
+      }
+   }
+
+   program->hashoffsets[i] = offset;
+   program->hashops[i] = op;
+}
+
+static qboolean IsIntegerLiteral(const char *text, int *value)
+{
+   char buf[16];
+
+   // only take numbers that print back the same, so the text of the argument
+   // doesn't change when it's read as a string
+   *value = atoi(text);
+   snprintf(buf, sizeof(buf), "%d", *value);
+
+   return !strcmp(buf, text);
+}
+
+/*
+==============
+ResolveStatement
+
+Works out what kind of statement op is from its tokens, and the event its
+command sends if that can be known up front.  Event numbers depend on the
+build, so this is run again on statements read from the script cache.
+==============
+*/
+static void ResolveStatement(scriptop_t *op)
+{
+   const char *name;
+   int         len;
+
+   op->event = 0;
+
+   name = op->argv[0];
+   len = strlen(name);
+   if(len && (name[len - 1] == ':'))
+   {
+      op->opcode = SOP_LABEL;
+   }
+   else if(!len || strchr(name, '.') || (name[0] == '*'))
+   {
+      op->opcode = SOP_COMMAND;
+   }
+   else if((name[0] == '$') || (name[0] == '@') || (name[0] == '%'))
+   {
+      op->event = (op->argc > 1) ? Event::EventNum(op->argv[1]) : 0;
+      if(!op->event)
+      {
+         op->opcode = SOP_COMMAND;
+      }
+      else if(name[0] == '$')
+      {
+         op->opcode = SOP_OBJECT;
+      }
+      else if(name[0] == '@')
+      {
+         op->opcode = SOP_SURFACE;
+      }
+      else
+      {
+         op->opcode = SOP_CONSOLE;
+      }
+   }
+   else
+   {
+      op->event = Event::EventNum(name);
+      op->opcode = op->event ? SOP_GLOBAL : SOP_COMMAND;
+   }
+}
+
+/*
+==============
+GameScript::Compile
+
+Tokenizes every line of the script once when it's loaded so that threads
+don't have to do it each time they run.  A thread's position in the text
+is still its program counter: each statement is looked up by the offset the
+tokenizer would start reading it from, so labels, goto, waits, Mark and
+Restore all work on the same positions they always did, and anything that
+leaves a thread somewhere unexpected just falls back to reading the text.
+==============
+*/
+void GameScript::Compile(void)
+{
+   scriptmarker_t mark;
+   scriptop_t    *op;
+   const char    *tok;
+   int            pass;
+   int            numops;
+   int            numargs;
+   int            numchars;
+   int            prevend;
+   int            labelend;
+   int            firstend;
+   int            argc;
+   int            len;
+
+   FreeProgram();
+
+   program = new scriptprogram_t;
+   memset(program, 0, sizeof(*program));
+
+   MarkPosition(&mark);
+
+   // count everything on the first pass, fill it in on the second
+   for(pass = 0; pass < 2; pass++)
+   {
+      Reset();
+
+      numops = 0;
+      numargs = 0;
+      numchars = 0;
+      prevend = 0;
+      labelend = -1;
+      op = nullptr;
+
+      while(TokenAvailable(true))
+      {
+         if(pass)
+         {
+            op = &program->ops[numops];
+            op->start = prevend;
+            op->line = line;
+            op->argv = &program->argv[numargs];
+            op->values = &program->values[numargs];
+         }
+
+         argc = 0;
+         firstend = 0;
+         while(TokenAvailable(false))
+         {
+            tok = GetToken(false);
+            if(!argc)
+            {
+               firstend = script_p - buffer;
+            }
+
+            if(argc == MAX_COMMANDS)
+            {
+               // leave it to the text, which reports the error
+               if(op)
+               {
+                  op->opcode = SOP_TEXT;
+               }
+               SkipToEOL();
+               break;
+            }
+
+            len = strlen(tok) + 1;
+            if(op)
+            {
+               memcpy(&program->strings[numchars], tok, len);
+               op->argv[argc] = &program->strings[numchars];
+               if(IsIntegerLiteral(tok, &op->values[argc]))
+               {
+                  op->intargs |= 1 << argc;
+               }
+            }
+
+            numchars += len;
+            argc++;
+            numargs++;
+         }
+
+         if(op)
+         {
+            op->end = script_p - buffer;
+            op->argc = argc;
+
+            if(op->opcode != SOP_TEXT)
+            {
+               ResolveStatement(op);
+
+               AddStatement(op->start, numops);
+
+               // a goto lands right after the label's token
+               if(labelend != -1)
+               {
+                  AddStatement(labelend, numops);
+               }
+            }
+
+            labelend = -1;
+            if((op->opcode == SOP_LABEL) && (argc == 1))
+            {
+               labelend = firstend;
+            }
+         }
+
+         prevend = script_p - buffer;
+         numops++;
+      }
+
+      if(!pass)
+      {
+         program->numops = numops;
+         program->numargs = numargs;
+         program->numchars = numchars;
+         program->ops = new scriptop_t[numops + 1];
+         memset(program->ops, 0, sizeof(scriptop_t) * (numops + 1));
+         program->argv = new const char *[numargs + 1];
+         program->values = new int[numargs + 1];
+         program->strings = new char[numchars + 1];
+
+         // two offsets lead to each statement at most
+         for(program->hashsize = 16; program->hashsize < numops * 4; program->hashsize <<= 1)
+            ;
+         program->hashoffsets = new int[program->hashsize];
+         program->hashops = new int[program->hashsize];
+         memset(program->hashoffsets, -1, sizeof(int) * program->hashsize);
+      }
+   }
+
+   RestorePosition(&mark);
+}
+
+/*
+==============
+GameScript::NextStatement
+
+Returns the compiled statement at the current position and moves past it,
+or NULL if the position isn't the start of one.  prev is the statement that
+was run last, which is almost always the one just before this one.
+==============
+*/
+const scriptop_t *GameScript::NextStatement(const scriptop_t *prev)
+{
+   scriptprogram_t  *prog;
+   const scriptop_t *op;
+   int               offset;
+   int               i;
+
+   prog = sourcescript->program;
+   if(!prog || tokenready)
+   {
+      return nullptr;
+   }
+
+   offset = script_p - buffer;
+
+   op = nullptr;
+   if(prev && (prev >= prog->ops) && (prev + 1 < prog->ops + prog->numops) && (prev[1].start == offset))
+   {
+      op = prev + 1;
+   }
+   else
+   {
+      for(i = (offset * 2654435761u) & (prog->hashsize - 1); prog->hashoffsets[i] != -1; i = (i + 1) & (prog->hashsize - 1))
+      {
+         if(prog->hashoffsets[i] == offset)
+         {
+            op = &prog->ops[prog->hashops[i]];
+            break;
+         }
+      }
+   }
+
+   if(!op || (op->opcode == SOP_TEXT))
+   {
+      return nullptr;
+   }
+
+   script_p = buffer + op->end;
+   line = op->line;
+
+   return op;
+}
+
+//
+// Script cache
+//
+// The labels and compiled statements of each script are written out to
+// <playerdir>/scriptcache when it's first loaded, along with the CRC and
+// length of the text they came from.  Loading the script again reads them back
+// in one go instead of tokenizing the whole file twice.  If the script has
+// changed the cache won't match, so it gets compiled and written out again.
+//
+
+#define SCRIPTCACHE_IDENT     (('C' << 24) + ('S' << 16) + ('G' << 8) + 'W')
+#define SCRIPTCACHE_VERSION   1     // bump this when Compile changes
+
+typedef struct
+{
+   int            ident;
+   int            version;
+   unsigned       crc;
+   int            length;
+   int            numlabels;
+   int            numops;
+   int            numargs;
+   int            numchars;
+   int            hashsize;
+   char           filename[MAX_QPATH];
+} scriptcacheheader_t;
+
+typedef struct
+{
+   int            opcode;
+   int            start;
+   int            end;
+   int            line;
+   int            argc;
+   int            firstarg;
+   unsigned       intargs;
+} scriptcacheop_t;
+
+void GameScript::CachePath(char *path, size_t size)
+{
+   char  name[MAX_QPATH];
+   char *p;
+
+   Q_strlcpy(name, filename.c_str(), sizeof(name));
+   for(p = name; *p; p++)
+   {
+      if((*p == '/') || (*p == '\\') || (*p == ':'))
+      {
+         *p = '_';
+      }
+   }
+
+   snprintf(path, size, "%s/scriptcache/%s.cache", gi.PlayerDir(), name);
+}
+
+/*
+==============
+GameScript::LoadCache
+
+Sets up the labels and program from the script cache.  Returns false if
+there's no cache for the script, or it doesn't match the text that was
+loaded.
+==============
+*/
+qboolean GameScript::LoadCache(void)
+{
+   char                 path[MAX_OSPATH];
+   FILE                *f;
+   long                 size;
+   long                 expected;
+   unsigned char       *data;
+   unsigned char       *p;
+   scriptcacheheader_t *header;
+   scriptmarker_t      *pos;
+   scriptcacheop_t     *cop;
+   scriptop_t          *op;
+   script_label_t      *label;
+   int                 *argoffsets;
+   qboolean             valid;
+   int                  i;
+
+   if(!g_scriptcache->value || (filename.length() >= MAX_QPATH))
+   {
+      return false;
+   }
+
+   CachePath(path, sizeof(path));
+   f = fopen(path, "rb");
+   if(!f)
+   {
+      return false;
+   }
+
+   fseek(f, 0, SEEK_END);
+   size = ftell(f);
+   fseek(f, 0, SEEK_SET);
+
+   if(size < (long)sizeof(scriptcacheheader_t))
+   {
+      fclose(f);
+      return false;
+   }
+
+   data = new unsigned char[size];
+   if((long)fread(data, 1, size, f) != size)
+   {
+      fclose(f);
+      delete[] data;
+      return false;
+   }
+   fclose(f);
+
+   header = (scriptcacheheader_t *)data;
+   if((header->ident != SCRIPTCACHE_IDENT) || (header->version != SCRIPTCACHE_VERSION) ||
+      (header->crc != crc) || (header->length != length) ||
+      strncmp(header->filename, filename.c_str(), sizeof(header->filename)) ||
+      (header->numlabels < 0) || (header->numops < 0) || (header->numargs < 0) ||
+      (header->numchars < 0) || (header->hashsize < 16) || (header->hashsize & (header->hashsize - 1)))
+   {
+      delete[] data;
+      return false;
+   }
+
+   expected = sizeof(scriptcacheheader_t) +
+      header->numlabels * sizeof(scriptmarker_t) +
+      header->numops * sizeof(scriptcacheop_t) +
+      header->numargs * sizeof(int) * 2 +
+      header->numchars +
+      header->hashsize * sizeof(int) * 2;
+   if(size != expected)
+   {
+      delete[] data;
+      return false;
+   }
+
+   pos = (scriptmarker_t *)(data + sizeof(scriptcacheheader_t));
+   for(i = 0; i < header->numlabels; i++)
+   {
+      if((pos[i].offset < 0) || (pos[i].offset > length))
+      {
+         gi.dprintf("Script cache for %s is damaged\n", filename.c_str());
+         delete[] data;
+         return false;
+      }
+   }
+
+   FreeLabels();
+   FreeProgram();
+
+   p = data + sizeof(scriptcacheheader_t);
+
+   labelList = new Container<script_label_t *>();
+   labelMap  = new GSLabelMap(labelKeyFunc);
+   labelList->Resize(header->numlabels);
+
+   pos = (scriptmarker_t *)p;
+   for(i = 0; i < header->numlabels; i++, pos++)
+   {
+      label = new script_label_t();
+      label->pos = *pos;
+      label->pos.token[MAXTOKEN - 1] = 0;
+      label->labelname = label->pos.token;
+      labelList->AddObject(label);
+      labelMap->insert(label);
+   }
+   p = (unsigned char *)pos;
+
+   program = new scriptprogram_t;
+   memset(program, 0, sizeof(*program));
+   program->numops = header->numops;
+   program->numargs = header->numargs;
+   program->numchars = header->numchars;
+   program->hashsize = header->hashsize;
+   program->ops = new scriptop_t[header->numops + 1];
+   memset(program->ops, 0, sizeof(scriptop_t) * (header->numops + 1));
+   program->argv = new const char *[header->numargs + 1];
+   program->values = new int[header->numargs + 1];
+   program->strings = new char[header->numchars + 1];
+   program->hashoffsets = new int[header->hashsize];
+   program->hashops = new int[header->hashsize];
+
+   cop = (scriptcacheop_t *)p;
+   p += header->numops * sizeof(scriptcacheop_t);
+
+   argoffsets = (int *)p;
+   p += header->numargs * sizeof(int);
+
+   memcpy(program->values, p, header->numargs * sizeof(int));
+   p += header->numargs * sizeof(int);
+
+   memcpy(program->strings, p, header->numchars);
+   program->strings[header->numchars] = 0;
+   p += header->numchars;
+
+   memcpy(program->hashoffsets, p, header->hashsize * sizeof(int));
+   p += header->hashsize * sizeof(int);
+
+   memcpy(program->hashops, p, header->hashsize * sizeof(int));
+
+   // each stage only runs if everything before it checked out
+   valid = true;
+   for(i = 0; valid && (i < header->numargs); i++)
+   {
+      if((argoffsets[i] < 0) || (argoffsets[i] >= header->numchars))
+      {
+         valid = false;
+         break;
+      }
+      program->argv[i] = &program->strings[argoffsets[i]];
+   }
+
+   if(valid)
+   {
+      for(i = 0; i < header->numops; i++, cop++)
+      {
+         if((cop->argc < 0) || (cop->argc > MAX_COMMANDS) || (cop->firstarg < 0) ||
+            (cop->firstarg + cop->argc > header->numargs) ||
+            (cop->start < 0) || (cop->end < cop->start) || (cop->end > length))
+         {
+            valid = false;
+            break;
+         }
+
+         op = &program->ops[i];
+         op->opcode = cop->opcode;
+         op->start = cop->start;
+         op->end = cop->end;
+         op->line = cop->line;
+         op->argc = cop->argc;
+         op->argv = &program->argv[cop->firstarg];
+         op->values = &program->values[cop->firstarg];
+         op->intargs = cop->intargs;
+
+         if((op->opcode != SOP_TEXT) && op->argc)
+         {
+            ResolveStatement(op);
+         }
+         else
+         {
+            op->opcode = SOP_TEXT;
+         }
+      }
+   }
+
+   if(valid)
+   {
+      for(i = 0; i < header->hashsize; i++)
+      {
+         if((program->hashoffsets[i] != -1) &&
+            ((program->hashops[i] < 0) || (program->hashops[i] >= header->numops)))
+         {
+            valid = false;
+            break;
+         }
+      }
+   }
+
+   delete[] data;
+
+   if(!valid)
+   {
+      gi.dprintf("Script cache for %s is damaged\n", filename.c_str());
+      FreeLabels();
+      FreeProgram();
+      return false;
+   }
+
+   return true;
+}
+
+/*
+==============
+GameScript::WriteCache
+
+Writes out the labels and program so the next load of the script can skip
+compiling it.
+==============
+*/
+void GameScript::WriteCache(void)
+{
+   char                 path[MAX_OSPATH];
+   FILE                *f;
+   scriptcacheheader_t  header;
+   scriptcacheop_t      cop;
+   scriptop_t          *op;
+   int                  offset;
+   int                  num;
+   int                  i;
+
+   if(!g_scriptcache->value || !program || !labelList || (filename.length() >= MAX_QPATH))
+   {
+      return;
+   }
+
+   CachePath(path, sizeof(path));
+   gi.CreatePath(path);
+   f = fopen(path, "wb");
+   if(!f)
+   {
+      gi.dprintf("Couldn't write script cache %s\n", path);
+      return;
+   }
+
+   num = labelList->NumObjects();
+
+   memset(&header, 0, sizeof(header));
+   header.ident = SCRIPTCACHE_IDENT;
+   header.version = SCRIPTCACHE_VERSION;
+   header.crc = crc;
+   header.length = length;
+   header.numlabels = num;
+   header.numops = program->numops;
+   header.numargs = program->numargs;
+   header.numchars = program->numchars;
+   header.hashsize = program->hashsize;
+   Q_strlcpy(header.filename, filename.c_str(), sizeof(header.filename));
+   fwrite(&header, sizeof(header), 1, f);
+
+   for(i = 1; i <= num; i++)
+   {
+      fwrite(&labelList->ObjectAt(i)->pos, sizeof(scriptmarker_t), 1, f);
+   }
+
+   for(i = 0; i < program->numops; i++)
+   {
+      op = &program->ops[i];
+      cop.opcode = op->opcode;
+      cop.start = op->start;
+      cop.end = op->end;
+      cop.line = op->line;
+      cop.argc = op->argc;
+      cop.firstarg = op->argv - program->argv;
+      cop.intargs = op->intargs;
+      fwrite(&cop, sizeof(cop), 1, f);
+   }
+
+   for(i = 0; i < program->numargs; i++)
+   {
+      offset = program->argv[i] - program->strings;
+      fwrite(&offset, sizeof(offset), 1, f);
+   }
+
+   fwrite(program->values, sizeof(int), program->numargs, f);
+   fwrite(program->strings, 1, program->numchars, f);
+   fwrite(program->hashoffsets, sizeof(int), program->hashsize, f);
+   fwrite(program->hashops, sizeof(int), program->hashsize, f);
+
+   fclose(f);
+}
+
 EXPORT_FROM_DLL void GameScript::Mark(GameScriptMarker *mark)
 {
    assert(mark);
@@ -67,6 +67,49 @@ template class EXPORT_FROM_DLL Container<script_label_t *>;
 
 class GSLabelMap; // haleyjd 20170608: fast lookup map
 
+extern cvar_t *g_scriptcache;
+
+// Compiled statements.  Each line of a script is tokenized once when the
+// script is loaded, with its command resolved to an event number where that
+// can be done up front.
+typedef enum
+{
+   SOP_TEXT,      // too long to compile; threads read it from the text
+   SOP_LABEL,     // label, skipped
+   SOP_GLOBAL,    // command to the thread
+   SOP_OBJECT,    // $target command
+   SOP_SURFACE,   // @surface command
+   SOP_CONSOLE,   // %console command
+   SOP_COMMAND    // anything else (variables, *entnum, unknown commands) goes through ProcessCommand
+} scriptopcode_t;
+
+typedef struct
+{
+   int            opcode;
+   int            start;      // text offset the statement is reached from
+   int            end;        // text offset after the statement has been read
+   int            line;
+   int            event;      // event number of the command
+   int            argc;
+   const char   **argv;
+   int           *values;     // integer values of the arguments in intargs
+   unsigned       intargs;    // bit for each argument that's an integer literal
+} scriptop_t;
+
+typedef struct
+{
+   scriptop_t    *ops;
+   int            numops;
+   int            numargs;
+   int            numchars;
+   const char   **argv;
+   int           *values;
+   char          *strings;
+   int           *hashoffsets;
+   int           *hashops;
+   int            hashsize;
+} scriptprogram_t;
+
 class EXPORT_FROM_DLL GameScript : public Script
 {
 protected:
@@ -74,6 +117,12 @@ protected:
    GSLabelMap                  *labelMap     = nullptr;
    GameScript                  *sourcescript;
    unsigned                     crc          = 0;
+   scriptprogram_t             *program      = nullptr;
+
+   void              AddStatement(int offset, int op);
+   void              CachePath(char *path, size_t size);
+   qboolean          LoadCache();
+   void              WriteCache();
 
 public:
    CLASS_PROTOTYPE(GameScript);
@@ -91,7 +140,12 @@ public:
    void              FreeLabels();
    void              FindLabels();
    qboolean          labelExists(const char *name);
+   const char       *LabelAtLine(int line);
    qboolean          Goto(const char *name);
+
+   void              FreeProgram();
+   void              Compile();
+   const scriptop_t *NextStatement(const scriptop_t *prev);
    virtual void      Archive(Archiver &arc)   override;
    virtual void      Unarchive(Archiver &arc) override;
 };
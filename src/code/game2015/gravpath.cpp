@@ -588,11 +588,16 @@ void GravPath::DrawPath(Event *ev)
 
    G_DebugBBox(origin, mins - origin, maxs - origin, 1, 0, 0, 1);
 
-   event = new Event(EV_DrawGravPath);
-   event->AddFloat(r);
-   event->AddFloat(g);
-   event->AddFloat(b);
-   PostEvent(event, 0.1f);
+   // keep drawing the path until the timer is cancelled.  Drawing it again
+   // while the timer is running replaces the timer's colours.
+   if(!IsTimerEvent(ev))
+   {
+      event = new Event(EV_DrawGravPath);
+      event->AddFloat(r);
+      event->AddFloat(g);
+      event->AddFloat(b);
+      Schedule(event, 0.1f);
+   }
 }
 
 int GravPath::NumNodes() const
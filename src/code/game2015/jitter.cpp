@@ -23,7 +23,7 @@ float offsetjitter_falloff;   // falloffrate for offset jitter
 
 Event EV_Jitter_DeactivateAngle("jitter_deactivate_angle");
 Event EV_Jitter_DeactivateOffset("jitter_deactivate_offset");
-Event EV_Jitter_ApplyJitter("jitter_apply");
+Event EV_Jitter_ApplyJitter("jitter_apply", EV_COALESCE);
 
 #define TOGGLE         1
 #define START_ON       2
@@ -201,7 +201,6 @@ EXPORT_FROM_DLL void GlobalJitter::Activate(Event *ev)
 EXPORT_FROM_DLL void GlobalJitter::DeactivateAngle(Event *ev)
 {
    float new_time, new_magnitude, new_falloff;
-   int num;
    GlobalJitter *ent;
 
    angleactive = false;
@@ -209,11 +208,10 @@ EXPORT_FROM_DLL void GlobalJitter::DeactivateAngle(Event *ev)
    new_magnitude = 0;
    new_falloff = 0;
 
-   num = 0;
    // go through all the GlobalJitters to see if there's any active ones
-   while((num = G_FindClass(num, "func_jitter_global")))
+   for(Entity *other : G_ClassEntities("func_jitter_global"))
    {
-      ent = (GlobalJitter *)G_GetEntity(num);
+      ent = (GlobalJitter *)other;
 
       if(!ent->angleactive)
          continue;
@@ -235,7 +233,6 @@ EXPORT_FROM_DLL void GlobalJitter::DeactivateAngle(Event *ev)
 EXPORT_FROM_DLL void GlobalJitter::DeactivateOffset(Event *ev)
 {
    float new_time, new_magnitude, new_falloff;
-   int num;
    GlobalJitter *ent;
 
    offsetactive = false;
@@ -243,11 +240,10 @@ EXPORT_FROM_DLL void GlobalJitter::DeactivateOffset(Event *ev)
    new_magnitude = 0;
    new_falloff = 0;
 
-   num = 0;
    // go through all the GlobalJitters to see if there's any active ones
-   while((num = G_FindClass(num, "func_jitter_global")))
+   for(Entity *other : G_ClassEntities("func_jitter_global"))
    {
-      ent = static_cast<GlobalJitter *>(G_GetEntity(num));
+      ent = static_cast<GlobalJitter *>(other);
 
       if(!ent->offsetactive)
          continue;
@@ -414,7 +410,6 @@ void RadiusJitter::Activate(Event *ev)
 
    if(angleactive || offsetactive)
    {
-      CancelEventsOfType(EV_Jitter_ApplyJitter);
       PostEvent(EV_Jitter_ApplyJitter, 0.1);
    }
 }
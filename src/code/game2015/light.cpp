@@ -109,6 +109,7 @@ void LightRamp::RampLight(Event *ev)
          rate = 0;
       }
       currentlevel = maxlevel;
+      CancelEventsOfType(EV_RampLight);
    }
    else if(currentlevel <= minlevel)
    {
@@ -117,10 +118,7 @@ void LightRamp::RampLight(Event *ev)
          rate = 0;
       }
       currentlevel = minlevel;
-   }
-   else
-   {
-      PostEvent(EV_RampLight, FRAMETIME);
+      CancelEventsOfType(EV_RampLight);
    }
 
    st[0] = 'L';
@@ -137,7 +135,7 @@ void LightRamp::StartRamp(Event *ev)
    if(rate)
    {
       rate = -rate;
-      CancelEventsOfType(EV_RampLight);
+      Schedule(EV_RampLight, FRAMETIME);
       ProcessEvent(EV_RampLight);
    }
 
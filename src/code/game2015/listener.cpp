@@ -13,10 +13,14 @@
 // DESCRIPTION:
 // 
 
+#include <ctype.h>
 #include "listener.h"
 #include "scriptvariable.h"
 #include "worldspawn.h"
 #include "scriptmaster.h"
+#include "eventprofile.h"
+#include "evtrace.h"
+#include "../elib/qstringmap.h"
 
 Event EV_Remove("immediateremove");
 Event EV_ScriptRemove("remove");
@@ -26,16 +30,244 @@ typedef struct eventcache_s
    Listener *obj;
    Event		*event;
    float		time;
+   float		interval;   // how often a scheduled event repeats, 0 for events that are only processed once
+   unsigned	sequence;   // order of posting, keeps events with the same time in FIFO order
+   int		heapindex;  // position in the event queue, -1 when not queued
 
    struct eventcache_s *next;
    struct eventcache_s *prev;
+
+   // list of the pending events belonging to obj
+   struct eventcache_s *objnext;
+   struct eventcache_s *objprev;
 } eventcache_t;
 
+// Initial size of the event pool.  The pool grows in chunks as it runs out,
+// up to g_eventpoolmax entries.
 #define MAX_EVENTS 2000
+#define EVENT_CACHE_CHUNK 512
+
+typedef struct eventchunk_s
+{
+   eventcache_t          events[EVENT_CACHE_CHUNK];
+   struct eventchunk_s  *next;
+} eventchunk_t;
+
+/*
+==============================================================================
+
+EventHeap
+
+Binary min-heap of pending events ordered on time and then on the order in
+which they were posted.  Posting, cancelling and postponing an event are
+O(log n) instead of the linear walk the sorted event list required.
+
+==============================================================================
+*/
+
+class EventHeap
+{
+private:
+   eventcache_t   **nodes;
+   int              numnodes;
+   int              maxnodes;
+   unsigned         sequence;
+
+   void             Place(eventcache_t *node, int index);
+   void             SiftUp(int index);
+   void             SiftDown(int index);
+
+public:
+                    EventHeap();
+                   ~EventHeap();
+
+   static qboolean  Before(const eventcache_t *a, const eventcache_t *b);
+
+   void             Reset();
+   void             Resize(int size);
+   int              NumEvents() const;
+   eventcache_t    *Top() const;
+   eventcache_t    *NodeAt(int index) const;
+   void             Insert(eventcache_t *node);
+   void             Remove(eventcache_t *node);
+   void             Reschedule(eventcache_t *node);
+};
+
+EventHeap::EventHeap()
+{
+   nodes    = NULL;
+   numnodes = 0;
+   maxnodes = 0;
+   sequence = 0;
+}
+
+EventHeap::~EventHeap()
+{
+   if(nodes)
+   {
+      delete[] nodes;
+      nodes = NULL;
+   }
+}
+
+inline qboolean EventHeap::Before(const eventcache_t *a, const eventcache_t *b)
+{
+   if(a->time != b->time)
+   {
+      return a->time < b->time;
+   }
+
+   // compare as a signed difference so that the order survives the sequence wrapping
+   return (int)(a->sequence - b->sequence) < 0;
+}
+
+inline void EventHeap::Place(eventcache_t *node, int index)
+{
+   nodes[index] = node;
+   node->heapindex = index;
+}
+
+void EventHeap::SiftUp(int index)
+{
+   eventcache_t *node;
+   int parent;
+
+   node = nodes[index];
+   while(index > 0)
+   {
+      parent = (index - 1) >> 1;
+      if(!Before(node, nodes[parent]))
+      {
+         break;
+      }
+
+      Place(nodes[parent], index);
+      index = parent;
+   }
+
+   Place(node, index);
+}
+
+void EventHeap::SiftDown(int index)
+{
+   eventcache_t *node;
+   int child;
+
+   node = nodes[index];
+   for(child = (index << 1) + 1; child < numnodes; child = (index << 1) + 1)
+   {
+      if((child + 1 < numnodes) && Before(nodes[child + 1], nodes[child]))
+      {
+         child++;
+      }
+
+      if(!Before(nodes[child], node))
+      {
+         break;
+      }
+
+      Place(nodes[child], index);
+      index = child;
+   }
+
+   Place(node, index);
+}
+
+void EventHeap::Reset()
+{
+   numnodes = 0;
+   sequence = 0;
+}
+
+void EventHeap::Resize(int size)
+{
+   eventcache_t **newnodes;
+
+   if(size <= maxnodes)
+   {
+      return;
+   }
+
+   newnodes = new eventcache_t *[size];
+   if(nodes)
+   {
+      memcpy(newnodes, nodes, sizeof(eventcache_t *) * numnodes);
+      delete[] nodes;
+   }
+
+   nodes = newnodes;
+   maxnodes = size;
+}
+
+inline int EventHeap::NumEvents() const
+{
+   return numnodes;
+}
+
+inline eventcache_t *EventHeap::Top() const
+{
+   if(!numnodes)
+   {
+      return NULL;
+   }
+
+   return nodes[0];
+}
+
+inline eventcache_t *EventHeap::NodeAt(int index) const
+{
+   assert((index >= 0) && (index < numnodes));
+   return nodes[index];
+}
+
+void EventHeap::Insert(eventcache_t *node)
+{
+   if(numnodes >= maxnodes)
+   {
+      Resize(maxnodes ? maxnodes * 2 : MAX_EVENTS);
+   }
+
+   node->sequence = sequence++;
+   Place(node, numnodes++);
+   SiftUp(node->heapindex);
+}
+
+void EventHeap::Remove(eventcache_t *node)
+{
+   eventcache_t *last;
+   int index;
+
+   index = node->heapindex;
+   assert((index >= 0) && (index < numnodes) && (nodes[index] == node));
+
+   node->heapindex = -1;
+   last = nodes[--numnodes];
+   if(last == node)
+   {
+      return;
+   }
+
+   Place(last, index);
+   if((index > 0) && Before(last, nodes[(index - 1) >> 1]))
+   {
+      SiftUp(index);
+   }
+   else
+   {
+      SiftDown(index);
+   }
+}
+
+// Called after the time of a queued node changes.  The node is treated as if it was
+// just posted so that it follows any other events with the same time.
+void EventHeap::Reschedule(eventcache_t *node)
+{
+   Remove(node);
+   Insert(node);
+}
 
 extern "C"
 {
-   eventcache_t   Events[MAX_EVENTS];
    int            numEvents = 0;
    cvar_t        *g_numevents;
 }
@@ -44,23 +276,27 @@ cvar_t *g_showevents;
 cvar_t *g_eventlimit;
 cvar_t *g_timeevents;
 cvar_t *g_watch;
+cvar_t *g_eventpoolmax;
+cvar_t *g_eventpoolshrink;
 
 eventcache_t FreeEventHead;
 eventcache_t *FreeEvents = &FreeEventHead;
-eventcache_t EventQueueHead =
-{
-   nullptr,         // obj
-   nullptr,         // event
-   0,               // time
-   &EventQueueHead, // next
-   &EventQueueHead  // prev
-};
-eventcache_t *EventQueue = &EventQueueHead;
+EventHeap EventQueue;
+
+eventchunk_t *EventChunks     = NULL;
+int           numEventChunks  = 0;
+int           eventPoolSize   = 0;
+int           peakEventsLevel = 0;
+int           peakEventsGame  = 0;
+int           eventPoolGrowth = 0;
+int           eventsPosted    = 0;
+int           eventsCoalesced = 0;
 
 Container<str *> *Event::commandList = NULL;
 Container<int> *Event::flagList = NULL;
 Container<int> *Event::sortedList = NULL;
 qboolean Event::dirtylist = false;
+EventNameMap *Event::nameMap = NULL;
 
 Event NullEvent;
 
@@ -71,6 +307,111 @@ ResponseDef Event::Responses[] =
    { NULL, NULL }
 };
 
+/*
+==============================================================================
+
+Event allocation
+
+Events are short lived, so rather than going through the heap like other
+classes they're allocated from a free list of blocks carved out of larger
+chunks.  Freed events go back on the free list and get reused by the events
+posted in the following frames.
+
+==============================================================================
+*/
+
+#define EVENT_BLOCKS_PER_CHUNK 512
+
+typedef union eventblock_u
+{
+   union eventblock_u   *next;
+   byte                  data[sizeof(Event)];
+} eventblock_t;
+
+static eventblock_t *FreeEventBlocks  = NULL;
+static int           eventChunks      = 0;
+static int           eventsLive       = 0;
+static int           eventsPeak       = 0;
+static int           eventsAllocated  = 0;
+static int           eventsRecycled   = 0;
+static int           eventFrame       = -1;
+static int           eventsThisFrame  = 0;
+static int           eventsLastFrame  = 0;
+
+EXPORT_FROM_DLL void *Event::operator new (size_t s)
+{
+   eventblock_t *block;
+   eventblock_t *chunk;
+   int i;
+
+   assert(s <= sizeof(eventblock_t));
+
+   if(!FreeEventBlocks)
+   {
+      chunk = reinterpret_cast<eventblock_t *>(::new char[sizeof(eventblock_t) * EVENT_BLOCKS_PER_CHUNK]);
+      for(i = EVENT_BLOCKS_PER_CHUNK - 1; i >= 0; i--)
+      {
+         chunk[i].next = FreeEventBlocks;
+         FreeEventBlocks = &chunk[i];
+      }
+      eventChunks++;
+   }
+   else
+   {
+      eventsRecycled++;
+   }
+
+   block = FreeEventBlocks;
+   FreeEventBlocks = block->next;
+
+   if(level.framenum != eventFrame)
+   {
+      eventFrame = level.framenum;
+      eventsLastFrame = eventsThisFrame;
+      eventsThisFrame = 0;
+   }
+
+   eventsThisFrame++;
+   eventsAllocated++;
+   eventsLive++;
+   if(eventsLive > eventsPeak)
+   {
+      eventsPeak = eventsLive;
+   }
+
+   // events come from their own pool, but still show up in the class
+   // memory report
+   Event::ClassInfo.AddInstance(sizeof(eventblock_t));
+
+   return block;
+}
+
+EXPORT_FROM_DLL void Event::operator delete (void *ptr)
+{
+   eventblock_t *block;
+
+   if(!ptr)
+   {
+      return;
+   }
+
+   block = reinterpret_cast<eventblock_t *>(ptr);
+   block->next = FreeEventBlocks;
+   FreeEventBlocks = block;
+
+   eventsLive--;
+   Event::ClassInfo.RemoveInstance(sizeof(eventblock_t));
+}
+
+EXPORT_FROM_DLL void Event::PrintAllocStats(void)
+{
+   gi.printf("Events live %d, peak %d\n"
+             "%d allocated, %d recycled, %d last frame\n"
+             "%d chunks, %d bytes in event pool (%d bytes per event)\n",
+             eventsLive, eventsPeak, eventsAllocated, eventsRecycled, eventsLastFrame,
+             eventChunks, eventChunks * EVENT_BLOCKS_PER_CHUNK * (int)sizeof(eventblock_t), (int)sizeof(eventblock_t));
+}
+
  int Event::NumEventCommands(void)
 {
    if(commandList)
@@ -82,6 +423,16 @@ ResponseDef Event::Responses[] =
    return 0;
 }
 
+ const char *Event::EventName(int eventnum)
+{
+   if(!commandList || (eventnum < 1) || (eventnum > commandList->NumObjects()))
+   {
+      return "NULL";
+   }
+
+   return commandList->ObjectAt(eventnum)->c_str();
+}
+
  int Event::compareEvents(const void *arg1, const void *arg2)
 {
    int ev1;
@@ -109,13 +460,32 @@ ResponseDef Event::Responses[] =
    }
 }
 
+// Event numbers by name, ignoring case
+class EventNameMap : public std::unordered_map<qstring, int, qstring::hash, qstring::caseequal>
+{
+};
+
+/*
+===============
+Event::AddToNameMap
+
+Adds an event to the name lookup table.  If two events differ only in case,
+the first one registered keeps the name.
+===============
+*/
+void Event::AddToNameMap(int eventnum)
+{
+   if(!nameMap)
+   {
+      nameMap = new EventNameMap;
+   }
+
+   nameMap->emplace(qstring(commandList->ObjectAt(eventnum)->c_str()), eventnum);
+}
+
 inline  int Event::FindEvent(const char *name)
 {
-   int eventnum;
-   int index;
-   int l;
-   int r;
-   int diff;
+   EventNameMap::const_iterator itr;
 
    assert(name);
    if(!name)
@@ -123,38 +493,14 @@ inline  int Event::FindEvent(const char *name)
       return 0;
    }
 
-   if(!commandList)
+   if(!nameMap)
    {
       return 0;
    }
 
-   if(dirtylist)
-   {
-      SortEventList();
-   }
-
-   l = 1;
-   r = sortedList->NumObjects();
-   while(r >= l)
-   {
-      index = (l + r) >> 1;
-      eventnum = sortedList->ObjectAt(index);
-      diff = stricmp(name, commandList->ObjectAt(eventnum)->c_str());
-      if(diff < 0)
-      {
-         r = index - 1;
-      }
-      else if(diff > 0)
-      {
-         l = index + 1;
-      }
-      else
-      {
-         return eventnum;
-      }
-   }
+   itr = nameMap->find(qstring(name));
 
-   return 0;
+   return (itr != nameMap->cend()) ? itr->second : 0;
 }
 
  int Event::FindEvent(str &name)
@@ -224,11 +570,15 @@ inline  int Event::FindEvent(const char *name)
       {
          text[p++] = 'C';
       }
+      if(flags & EV_COALESCE)
+      {
+         text[p++] = 'M';
+      }
 
       gi.printf("%4d : %s%s\n", eventnum, text.c_str(), name.c_str());
    }
 
-   gi.printf("\n* = console command.\nC = cheat command.\n\n"
+   gi.printf("\n* = console command.\nC = cheat command.\nM = merged with a pending copy when posted.\n\n"
              "Printed %d of %d total commands.\n", num, n - hidden);
 
    if(developer->value && hidden)
@@ -256,7 +606,11 @@ inline  int Event::FindEvent(const char *name)
 
    dirtylist = false;
 
-   NullEvent.data = NULL;
+   AddToNameMap(NullEvent.eventnum);
+
+   NullEvent.args = NULL;
+   NullEvent.numargs = 0;
+   NullEvent.maxargs = 0;
    NullEvent.info.inuse = 0;
    NullEvent.info.source = EV_FROM_CODE;
    NullEvent.info.flags = 0;
@@ -293,7 +647,6 @@ Event::Event(int num) : Class()
    }
 
    eventnum = num;
-   data = NULL;
    info.inuse = 0;
    info.source = EV_FROM_CODE;
    info.linenumber = 0;
@@ -302,12 +655,8 @@ Event::Event(int num) : Class()
 
 Event::Event(const Event &ev) : Class()
 {
-   int num;
-   int i;
-
    eventnum = ev.eventnum;
    assert((eventnum > 0) && eventnum <= commandList->NumObjects());
-   data = NULL;
 
    name = commandList->ObjectAt(eventnum)->c_str();
    info.inuse      = 0;
@@ -316,25 +665,11 @@ Event::Event(const Event &ev) : Class()
    info.linenumber = ev.info.linenumber;
    threadnum       = ev.threadnum;
 
-   if(ev.data)
-   {
-      num = ev.data->NumObjects();
-
-      data = new Container<str>();
-      data->Resize(num);
-
-      for(i = 1; i <= num; i++)
-      {
-         data->AddObject(ev.data->ObjectAt(i));
-      }
-   }
+   CopyArgs(ev);
 }
 
 Event::Event(const Event *ev) : Class()
 {
-   int num;
-   int i;
-
    assert(ev);
    if(!ev)
    {
@@ -343,25 +678,14 @@ Event::Event(const Event *ev) : Class()
 
    eventnum = ev->eventnum;
    assert((eventnum > 0) && eventnum <= commandList->NumObjects());
-   data = NULL;
    name = commandList->ObjectAt(eventnum)->c_str();
    info.inuse      = 0;
    info.source     = ev->info.source;
    info.flags      = ev->info.flags;
    info.linenumber = ev->info.linenumber;
    threadnum       = ev->threadnum;
-   if(ev->data)
-   {
-      num = ev->data->NumObjects();
-
-      data = new Container<str>();
-      data->Resize(num);
 
-      for(i = 1; i <= num; i++)
-      {
-         data->AddObject(ev->data->ObjectAt(i));
-      }
-   }
+   CopyArgs(*ev);
 }
 
 Event::Event(const char *command, int flags) : Class()
@@ -388,13 +712,13 @@ Event::Event(const char *command, int flags) : Class()
       flagList->AddObject((int)flags);
       sortedList->AddObject(eventnum);
       dirtylist = true;
+      AddToNameMap(eventnum);
    }
 
    // Use the name stored in the command list in case the string passed in 
    // is not in static memory.
    name = commandList->ObjectAt(eventnum)->c_str();
 
-   data = NULL;
    info.inuse = 0;
    info.source = EV_FROM_CODE;
    info.linenumber = 0;
@@ -441,12 +765,12 @@ Event::Event(str &command, int flags) : Class()
       flagList->AddObject(flags);
       sortedList->AddObject(eventnum);
       dirtylist = true;
+      AddToNameMap(eventnum);
    }
 
    // Use the name stored in the command list since the string passed in 
    // is not in static memory.
    name = commandList->ObjectAt(eventnum)->c_str();
-   data = NULL;
    info.inuse = 0;
    info.source = EV_FROM_CODE;
    info.linenumber = 0;
@@ -473,57 +797,477 @@ Event::Event(str &command, int flags) : Class()
 
  Event::~Event()
 {
-   if(data)
+   ClearArgs();
+}
+
+Event &Event::operator = (const Event &ev)
+{
+   if(this != &ev)
    {
-      delete data;
-      data = NULL;
+      eventnum  = ev.eventnum;
+      name      = ev.name;
+      info      = ev.info;
+      threadnum = ev.threadnum;
+
+      CopyArgs(ev);
    }
+
+   return *this;
 }
 
- void Event::SetThread(ScriptThread *thread)
+// Script tokens are mostly the same names and numbers over and over, so they
+// are kept once in a table shared by every event instead of being copied into
+// each one.  Entries are never freed, since events anywhere may point at them.
+#define EVENT_MAX_INTERNED          4096
+#define EVENT_MAX_INTERNED_LENGTH   64
+
+static auto internKeyFunc = [] (str *s) { return s->c_str(); };
+
+class InternedStringMap : public qstringmap<str *, decltype(internKeyFunc)>
 {
-   if(thread)
+public:
+   using qstringmap::qstringmap;
+};
+
+static InternedStringMap *internedStrings = NULL;
+static int                numInternedStrings = 0;
+
+/*
+===============
+G_InternString
+
+Returns the table's copy of text, or NULL if it's too long or the table is
+full.
+===============
+*/
+static str *G_InternString(const char *text)
+{
+   str *s;
+
+   if(!internedStrings)
    {
-      threadnum = thread->ThreadNum();
+      internedStrings = new InternedStringMap(internKeyFunc);
    }
-   else
+
+   s = internedStrings->find(text);
+   if(s)
    {
-      threadnum = -1;
+      return s;
    }
-}
 
- ScriptThread *Event::GetThread(void)
-{
-   if(threadnum != -1)
+   if((numInternedStrings >= EVENT_MAX_INTERNED) || (strlen(text) >= EVENT_MAX_INTERNED_LENGTH))
    {
-      return Director.GetThread(threadnum);
+      return NULL;
    }
 
-   return NULL;
+   s = new str(text);
+   internedStrings->insert(s);
+   numInternedStrings++;
+
+   return s;
 }
 
- void Event::Error(const char *fmt, ...)
+// Arguments that are read as text and may name a script variable
+static inline qboolean EV_IsStringArg(const eventarg_t *arg)
 {
-   va_list       argptr;
-   char          text[1024];
-   ScriptThread *thread;
-   const char   *filename;
+   return (arg->type == EV_ARG_STRING) || (arg->type == EV_ARG_INTERNED) || (arg->type == EV_ARG_VARIABLE);
+}
 
-   va_start(argptr, fmt);
-   vsnprintf(text, sizeof(text), fmt, argptr);
-   va_end(argptr);
+static inline qboolean EV_OwnsText(const eventarg_t *arg)
+{
+   return arg->text && (arg->type != EV_ARG_INTERNED) && (arg->type != EV_ARG_VARIABLE);
+}
 
-   switch(GetSource())
+/*
+===============
+EV_ArgVariable
+
+Returns the script variable a string argument names, if there is one.  Bound
+variables are used as long as they're still around, otherwise the name is
+looked up the same as it always was.
+===============
+*/
+static ScriptVariable *EV_ArgVariable(const eventarg_t *arg)
+{
+   HandleBase      handle;
+   ScriptVariable *var;
+
+   if(!EV_IsStringArg(arg))
    {
-   default:
-   case EV_FROM_CODE:
-      gi.dprintf("Game: '%s' : %s\n", getName().c_str(), text);
-      break;
+      return NULL;
+   }
 
-   case EV_FROM_SCRIPT:
-      thread = GetThread();
-      filename = "Dead script";
-      if(thread)
+   if(arg->type == EV_ARG_VARIABLE)
+   {
+      handle.index = arg->variable.index;
+      handle.serial = arg->variable.serial;
+      var = (ScriptVariable *)handle.GetPtr();
+      if(var)
+      {
+         return var;
+      }
+   }
+
+   return Director.GetExistingVariable(arg->text->c_str());
+}
+
+/*
+===============
+Event::AddToken
+
+Adds a token from a script or the console.  Short tokens are interned, and if
+one names a variable outside the local group, the variable is bound to it so
+that reading the argument doesn't have to look the name up again.  Local
+variables belong to whichever thread reads the event, so they're always looked
+up when they're read.
+===============
+*/
+void Event::AddToken(const char *text)
+{
+   ScriptVariable *var;
+   eventarg_t     *arg;
+   HandleBase      handle;
+   str            *s;
+
+   s = G_InternString(text);
+   if(!s)
+   {
+      AddString(text);
+      return;
+   }
+
+   var = NULL;
+   if(strncmp(text, "local.", 6))
+   {
+      var = Director.GetExistingVariable(text);
+   }
+
+   if(var)
+   {
+      handle.InitHandle(var);
+      arg = NewArg(EV_ARG_VARIABLE);
+      arg->variable.index = handle.index;
+      arg->variable.serial = handle.serial;
+   }
+   else
+   {
+      arg = NewArg(EV_ARG_INTERNED);
+   }
+   arg->text = s;
+}
+
+void Event::AddTokens(int argc, const char **argv)
+{
+   int i;
+
+   for(i = 0; i < argc; i++)
+   {
+      assert(argv[i]);
+      AddToken(argv[i]);
+   }
+}
+
+void Event::CopyArgs(const Event &ev)
+{
+   int i;
+
+   ClearArgs();
+
+   if(!ev.numargs)
+   {
+      return;
+   }
+
+   if(ev.shared)
+   {
+      shared = ev.shared;
+      shared->refcount++;
+      args = shared->args;
+      numargs = shared->numargs;
+      maxargs = shared->numargs;
+      return;
+   }
+
+   if(ev.numargs <= EVENT_INLINE_ARGS)
+   {
+      args = inlineargs;
+      maxargs = EVENT_INLINE_ARGS;
+   }
+   else
+   {
+      args = new eventarg_t[ev.numargs];
+      maxargs = ev.numargs;
+   }
+
+   numargs = ev.numargs;
+   memcpy(args, ev.args, sizeof(eventarg_t) * numargs);
+
+   for(i = 0; i < numargs; i++)
+   {
+      if(EV_OwnsText(&args[i]))
+      {
+         args[i].text = new str(*args[i].text);
+      }
+   }
+}
+
+static void FreeEventArgs(eventarg_t *args, int numargs)
+{
+   int i;
+
+   for(i = 0; i < numargs; i++)
+   {
+      if(EV_OwnsText(&args[i]))
+      {
+         delete args[i].text;
+      }
+   }
+}
+
+void Event::ClearArgs(void)
+{
+   if(shared)
+   {
+      if(--shared->refcount <= 0)
+      {
+         FreeEventArgs(shared->args, shared->numargs);
+         delete[] shared->args;
+         delete shared;
+      }
+      shared = nullptr;
+   }
+   else
+   {
+      FreeEventArgs(args, numargs);
+
+      if(args && (args != inlineargs))
+      {
+         delete[] args;
+      }
+   }
+
+   args = NULL;
+   numargs = 0;
+   maxargs = 0;
+}
+
+/*
+===============
+Event::ShareArgs
+
+Moves the arguments into a block that copies of the event share instead of
+copying them.  Used when one event is sent to many listeners.
+===============
+*/
+void Event::ShareArgs(void)
+{
+   eventargblock_t *block;
+
+   if(shared || !numargs)
+   {
+      return;
+   }
+
+   block = new eventargblock_t;
+   block->refcount = 1;
+   block->numargs = numargs;
+   if(args == inlineargs)
+   {
+      block->args = new eventarg_t[numargs];
+      memcpy(block->args, args, sizeof(eventarg_t) * numargs);
+   }
+   else
+   {
+      block->args = args;
+   }
+
+   shared = block;
+   args = block->args;
+   maxargs = numargs;
+}
+
+/*
+===============
+Event::UnshareArgs
+
+Gives the event its own copy of shared arguments so they can be changed.
+===============
+*/
+void Event::UnshareArgs(void)
+{
+   eventargblock_t *block;
+   int              i;
+
+   block = shared;
+   shared = nullptr;
+
+   if(block->numargs <= EVENT_INLINE_ARGS)
+   {
+      args = inlineargs;
+      maxargs = EVENT_INLINE_ARGS;
+   }
+   else
+   {
+      args = new eventarg_t[block->numargs];
+      maxargs = block->numargs;
+   }
+
+   numargs = block->numargs;
+   memcpy(args, block->args, sizeof(eventarg_t) * numargs);
+
+   if(--block->refcount <= 0)
+   {
+      // nobody else is using them, so just take the strings
+      delete[] block->args;
+      delete block;
+   }
+   else
+   {
+      for(i = 0; i < numargs; i++)
+      {
+         if(EV_OwnsText(&args[i]))
+         {
+            args[i].text = new str(*args[i].text);
+         }
+      }
+   }
+}
+
+/*
+===============
+Event::ArgText
+
+Returns the text form of an argument.  Typed arguments are formatted the same
+way they used to be when they were added, but only when the text is asked for.
+===============
+*/
+const char *Event::ArgText(eventarg_t *arg)
+{
+   char text[128];
+
+   if(arg->text)
+   {
+      return arg->text->c_str();
+   }
+
+   switch(arg->type)
+   {
+   case EV_ARG_INTEGER:
+      snprintf(text, sizeof(text), "%d", arg->integer);
+      break;
+
+   case EV_ARG_FLOAT:
+      snprintf(text, sizeof(text), "%f", arg->value);
+      break;
+
+   case EV_ARG_VECTOR:
+      snprintf(text, sizeof(text), "(%f %f %f)", arg->vector[0], arg->vector[1], arg->vector[2]);
+      break;
+
+   case EV_ARG_ENTITY:
+      snprintf(text, sizeof(text), "*%d", arg->entnum);
+      break;
+
+   default:
+      text[0] = 0;
+      break;
+   }
+
+   arg->text = new str(text);
+   return arg->text->c_str();
+}
+
+/*
+===============
+Event::ArgDigest
+
+Hash of the arguments for event traces.  Typed arguments are hashed by value
+so that the digest doesn't depend on whether they've been converted to text.
+===============
+*/
+unsigned Event::ArgDigest(void)
+{
+   const unsigned char *data;
+   unsigned             hash;
+   size_t               size;
+   int                  type;
+   int                  i;
+
+   hash = 0;
+   for(i = 0; i < numargs; i++)
+   {
+      // tokens hash the same however they were stored
+      type = EV_IsStringArg(&args[i]) ? EV_ARG_STRING : args[i].type;
+      hash = G_HashData(&type, sizeof(type), hash);
+
+      switch(type)
+      {
+      case EV_ARG_STRING:
+         data = (const unsigned char *)args[i].text->c_str();
+         size = args[i].text->length();
+         break;
+
+      case EV_ARG_VECTOR:
+         data = (const unsigned char *)args[i].vector;
+         size = sizeof(args[i].vector);
+         break;
+
+      default:
+         data = (const unsigned char *)&args[i].integer;
+         size = sizeof(args[i].integer);
+         break;
+      }
+
+      hash = G_HashData(data, size, hash);
+   }
+
+   return hash;
+}
+
+ void Event::SetThread(ScriptThread *thread)
+{
+   if(thread)
+   {
+      threadnum = thread->ThreadNum();
+   }
+   else
+   {
+      threadnum = -1;
+   }
+}
+
+ ScriptThread *Event::GetThread(void)
+{
+   if(threadnum != -1)
+   {
+      return Director.GetThread(threadnum);
+   }
+
+   return NULL;
+}
+
+ void Event::Error(const char *fmt, ...)
+{
+   va_list       argptr;
+   char          text[1024];
+   ScriptThread *thread;
+   const char   *filename;
+
+   va_start(argptr, fmt);
+   vsnprintf(text, sizeof(text), fmt, argptr);
+   va_end(argptr);
+
+   switch(GetSource())
+   {
+   default:
+   case EV_FROM_CODE:
+      gi.dprintf("Game: '%s' : %s\n", getName().c_str(), text);
+      break;
+
+   case EV_FROM_SCRIPT:
+      thread = GetThread();
+      filename = "Dead script";
+      if(thread)
       {
          filename = thread->Filename();
       }
@@ -538,35 +1282,38 @@ Event::Event(str &command, int flags) : Class()
 
  void Event::AddEntity(Entity *ent)
 {
-   char text[128];
-
    //assert( ent );
    if(!ent)
    {
-      snprintf(text, sizeof(text), "*0");
+      NewArg(EV_ARG_ENTITY)->entnum = 0;
    }
    else
    {
-      snprintf(text, sizeof(text), "*%d", ent->entnum);
+      NewArg(EV_ARG_ENTITY)->entnum = ent->entnum;
    }
-   AddString(text);
 }
 
  qboolean Event::IsVectorAt(int pos)
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return false;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(!EV_IsStringArg(arg))
+   {
+      return (arg->type == EV_ARG_VECTOR);
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
    if(var)
    {
       text = var->stringValue();
@@ -587,50 +1334,58 @@ Event::Event(str &command, int flags) : Class()
    const char		*name;
    int				t;
    ScriptVariable *var;
+   eventarg_t     *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return false;
    }
 
-   name = data->ObjectAt(pos).c_str();
-   assert(name);
-
-   var = Director.GetExistingVariable(name);
-   if(var)
-   {
-      name = var->stringValue();
-   }
-
-   if(name[0] == '$')
+   if(arg->type == EV_ARG_ENTITY)
    {
-      t = G_FindTarget(0, &name[1]);
-      if(!t)
-      {
-         Error("Entity with targetname of '%s' not found", &name[1]);
-
-         return false;
-      }
+      t = arg->entnum;
    }
    else
    {
-      if(name[0] != '*')
-      {
-         Error("Expecting a '*'-prefixed entity number but found '%s'.", name);
+      name = ArgText(arg);
+      assert(name);
 
-         return false;
+      var = EV_ArgVariable(arg);
+      if(var)
+      {
+         name = var->stringValue();
       }
 
-      if(!IsNumeric(&name[1]))
+      if(name[0] == '$')
       {
-         Error("Expecting a numeric value but found '%s'.", &name[1]);
+         t = G_FindTarget(0, &name[1]);
+         if(!t)
+         {
+            Error("Entity with targetname of '%s' not found", &name[1]);
 
-         return false;
+            return false;
+         }
       }
       else
       {
-         t = atoi(&name[1]);
+         if(name[0] != '*')
+         {
+            Error("Expecting a '*'-prefixed entity number but found '%s'.", name);
+
+            return false;
+         }
+
+         if(!IsNumeric(&name[1]))
+         {
+            Error("Expecting a numeric value but found '%s'.", &name[1]);
+
+            return false;
+         }
+         else
+         {
+            t = atoi(&name[1]);
+         }
       }
    }
 
@@ -648,17 +1403,23 @@ Event::Event(str &command, int flags) : Class()
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return false;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(!EV_IsStringArg(arg))
+   {
+      return (arg->type == EV_ARG_INTEGER) || (arg->type == EV_ARG_FLOAT);
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
    if(var)
    {
       text = var->stringValue();
@@ -671,17 +1432,18 @@ Event::Event(str &command, int flags) : Class()
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return "";
    }
 
-   text = data->ObjectAt(pos).c_str();
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
    if(var)
    {
       return var->stringValue();
@@ -693,17 +1455,28 @@ EXPORT_FROM_DLL int Event::GetInteger(int pos)
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return 0;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(arg->type == EV_ARG_INTEGER)
+   {
+      return arg->integer;
+   }
+   else if(arg->type == EV_ARG_FLOAT)
+   {
+      return (int)arg->value;
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
+
    if(var)
    {
       if(!IsNumeric(var->stringValue()))
@@ -726,17 +1499,28 @@ EXPORT_FROM_DLL double Event::GetDouble(int pos)
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return 0;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(arg->type == EV_ARG_FLOAT)
+   {
+      return (double)arg->value;
+   }
+   else if(arg->type == EV_ARG_INTEGER)
+   {
+      return (double)arg->integer;
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
+
    if(var)
    {
       if(!IsNumeric(var->stringValue()))
@@ -759,17 +1543,28 @@ EXPORT_FROM_DLL float Event::GetFloat(int pos)
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return 0;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(arg->type == EV_ARG_FLOAT)
+   {
+      return arg->value;
+   }
+   else if(arg->type == EV_ARG_INTEGER)
+   {
+      return (float)arg->integer;
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
+
    if(var)
    {
       if(!IsNumeric(var->stringValue()))
@@ -792,17 +1587,23 @@ EXPORT_FROM_DLL Vector Event::GetVector(int pos)
 {
    const char *text;
    ScriptVariable *var;
+   eventarg_t *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return vec_zero;
    }
 
-   text = data->ObjectAt(pos).c_str();
+   if(arg->type == EV_ARG_VECTOR)
+   {
+      return Vector(arg->vector[0], arg->vector[1], arg->vector[2]);
+   }
+
+   text = ArgText(arg);
    assert(text);
 
-   var = Director.GetExistingVariable(text);
+   var = EV_ArgVariable(arg);
    if(var)
    {
       text = var->stringValue();
@@ -828,50 +1629,58 @@ EXPORT_FROM_DLL Entity *Event::GetEntity(int pos)
    const char		*name;
    int				t;
    ScriptVariable *var;
+   eventarg_t     *arg;
 
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return NULL;
    }
 
-   name = data->ObjectAt(pos).c_str();
-   assert(name);
-
-   var = Director.GetExistingVariable(name);
-   if(var)
-   {
-      name = var->stringValue();
-   }
-
-   if(name[0] == '$')
+   if(arg->type == EV_ARG_ENTITY)
    {
-      t = G_FindTarget(0, &name[1]);
-      if(!t)
-      {
-         Error("Entity with targetname of '%s' not found", &name[1]);
-
-         return NULL;
-      }
+      t = arg->entnum;
    }
    else
    {
-      if(name[0] != '*')
-      {
-         Error("Expecting a '*'-prefixed entity number but found '%s'.", name);
+      name = ArgText(arg);
+      assert(name);
 
-         return NULL;
+      var = EV_ArgVariable(arg);
+      if(var)
+      {
+         name = var->stringValue();
       }
 
-      if(!IsNumeric(&name[1]))
+      if(name[0] == '$')
       {
-         Error("Expecting a numeric value but found '%s'.", &name[1]);
+         t = G_FindTarget(0, &name[1]);
+         if(!t)
+         {
+            Error("Entity with targetname of '%s' not found", &name[1]);
 
-         return NULL;
+            return NULL;
+         }
       }
       else
       {
-         t = atoi(&name[1]);
+         if(name[0] != '*')
+         {
+            Error("Expecting a '*'-prefixed entity number but found '%s'.", name);
+
+            return NULL;
+         }
+
+         if(!IsNumeric(&name[1]))
+         {
+            Error("Expecting a numeric value but found '%s'.", &name[1]);
+
+            return NULL;
+         }
+         else
+         {
+            t = atoi(&name[1]);
+         }
       }
    }
 
@@ -886,19 +1695,30 @@ EXPORT_FROM_DLL Entity *Event::GetEntity(int pos)
 
 EXPORT_FROM_DLL ScriptVariable *Event::GetVariable(int pos)
 {
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   ScriptVariable *var;
+   eventarg_t     *arg;
+
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return NULL;
    }
 
-   return Director.GetVariable(data->ObjectAt(pos).c_str());
+   if(arg->type == EV_ARG_VARIABLE)
+   {
+      var = EV_ArgVariable(arg);
+      if(var)
+      {
+         return var;
+      }
+   }
+
+   return Director.GetVariable(ArgText(arg));
 }
 
 EXPORT_FROM_DLL void Event::Archive(Archiver &arc)
 {
    str name;
-   int num;
    int i;
 
    name = getName();
@@ -907,51 +1727,36 @@ EXPORT_FROM_DLL void Event::Archive(Archiver &arc)
    arc.WriteRaw(&info, sizeof(info));
    arc.WriteInteger(threadnum);
 
-   if(!data)
+   // Arguments are written as text, the same as they were before they had
+   // types, so that savegames don't depend on how an argument was added.
+   arc.WriteInteger(numargs);
+   for(i = 0; i < numargs; i++)
    {
-      arc.WriteInteger(0);
-   }
-   else
-   {
-      num = data->NumObjects();
-
-      arc.WriteInteger(num);
-      for(i = 1; i <= num; i++)
-      {
-         arc.WriteString(data->ObjectAt(i));
-      }
+      name = ArgText(&args[i]);
+      arc.WriteString(name);
    }
 }
 
 EXPORT_FROM_DLL void Event::Unarchive(Archiver &arc)
 {
-   Event ev;
-   str name;
+   str text;
    int i;
    int num;
 
-   if(data)
-   {
-      delete data;
-      data = NULL;
-   }
+   ClearArgs();
 
-   arc.ReadString(&name);
-   *this = Event(name);
+   arc.ReadString(&text);
+   eventnum = (int)Event(text);
+   name = commandList->ObjectAt(eventnum)->c_str();
 
    arc.ReadRaw(&info, sizeof(info));
    arc.ReadInteger(&threadnum);
 
    arc.ReadInteger(&num);
-   if(num)
+   for(i = 1; i <= num; i++)
    {
-      data = new Container<str>();
-      data->Resize(num);
-      for(i = 1; i <= num; i++)
-      {
-         arc.ReadString(&name);
-         data->AddObject(name);
-      }
+      arc.ReadString(&text);
+      AddString(text);
    }
 }
 
@@ -1011,7 +1816,7 @@ EXPORT_FROM_DLL qboolean Listener::ValidEvent(Event &e)
       return false;
    }
 
-   return (c->responseLookup[ev] != nullptr);
+   return (c->GetResponse(ev) != nullptr);
 }
 
 EXPORT_FROM_DLL qboolean Listener::ValidEvent(const char *name)
@@ -1027,27 +1832,299 @@ EXPORT_FROM_DLL qboolean Listener::ValidEvent(const char *name)
       return false;
    }
 
-   return (c->responseLookup[ev] != nullptr);
+   return (c->GetResponse(ev) != nullptr);
 }
 
-EXPORT_FROM_DLL qboolean Listener::EventPending(Event &ev)
+/*
+==============================================================================
+
+Event pool
+
+The pending event entries are allocated in chunks that are never moved once
+they're allocated, so the pool can grow while events are pending.
+
+==============================================================================
+*/
+
+// Prints the events holding the most entries in the pool
+static void G_PrintTopPendingEvents(int maxnames)
+{
+   int *counts;
+   int num;
+   int best;
+   int i;
+   int j;
+
+   num = Event::NumEventCommands();
+   if(!num)
+   {
+      return;
+   }
+
+   counts = new int[num];
+   memset(counts, 0, sizeof(int) * num);
+
+   for(i = 0; i < EventQueue.NumEvents(); i++)
+   {
+      counts[(int)*EventQueue.NodeAt(i)->event]++;
+   }
+
+   for(j = 0; j < maxnames; j++)
+   {
+      best = 0;
+      for(i = 1; i < num; i++)
+      {
+         if(counts[i] > counts[best])
+         {
+            best = i;
+         }
+      }
+
+      if(!counts[best])
+      {
+         break;
+      }
+
+      gi.printf("%6d %s\n", counts[best], Event(best).getName().c_str());
+      counts[best] = 0;
+   }
+
+   delete[] counts;
+}
+
+static void G_AddEventChunk(void)
+{
+   eventchunk_t *chunk;
+   eventcache_t *e;
+   int i;
+
+   chunk = new eventchunk_t;
+   memset(chunk, 0, sizeof(eventchunk_t));
+
+   for(e = &chunk->events[0], i = 0; i < EVENT_CACHE_CHUNK; i++, e++)
+   {
+      e->heapindex = -1;
+      LL_Add(FreeEvents, e, next, prev);
+   }
+
+   chunk->next = EventChunks;
+   EventChunks = chunk;
+   numEventChunks++;
+   eventPoolSize += EVENT_CACHE_CHUNK;
+
+   EventQueue.Resize(eventPoolSize);
+}
+
+/*
+===============
+G_GrowEventPool
+
+Called when the pool runs out of free entries.  Returns false once the pool
+has reached g_eventpoolmax.
+===============
+*/
+static qboolean G_GrowEventPool(void)
+{
+   if(g_eventpoolmax->value && (eventPoolSize + EVENT_CACHE_CHUNK > (int)g_eventpoolmax->value))
+   {
+      gi.dprintf("Event pool full at %d entries.  Events holding the most entries:\n", eventPoolSize);
+      G_PrintTopPendingEvents(10);
+      return false;
+   }
+
+   G_AddEventChunk();
+   eventPoolGrowth++;
+
+   if(developer->value)
+   {
+      gi.dprintf("Event pool grown to %d entries.  Events holding the most entries:\n", eventPoolSize);
+      G_PrintTopPendingEvents(5);
+   }
+
+   return true;
+}
+
+/*
+===============
+G_ResetEventPool
+
+Puts every entry back on the free list, optionally releasing the chunks
+beyond the initial size of the pool.
+===============
+*/
+static void G_ResetEventPool(qboolean shrink)
+{
+   eventchunk_t *chunk;
+   eventchunk_t *next;
+   eventcache_t *e;
+   int keep;
+   int i;
+
+   LL_Reset(FreeEvents, next, prev);
+
+   keep = (MAX_EVENTS + EVENT_CACHE_CHUNK - 1) / EVENT_CACHE_CHUNK;
+   if(shrink)
+   {
+      while(numEventChunks > keep)
+      {
+         next = EventChunks->next;
+         delete EventChunks;
+         EventChunks = next;
+         numEventChunks--;
+         eventPoolSize -= EVENT_CACHE_CHUNK;
+      }
+   }
+
+   for(chunk = EventChunks; chunk != NULL; chunk = chunk->next)
+   {
+      memset(chunk->events, 0, sizeof(chunk->events));
+      for(e = &chunk->events[0], i = 0; i < EVENT_CACHE_CHUNK; i++, e++)
+      {
+         e->heapindex = -1;
+         LL_Add(FreeEvents, e, next, prev);
+      }
+   }
+
+   while(numEventChunks < keep)
+   {
+      G_AddEventChunk();
+   }
+
+   numEvents = 0;
+   peakEventsLevel = 0;
+   eventsPosted = 0;
+   eventsCoalesced = 0;
+}
+
+EXPORT_FROM_DLL void G_EventPoolInfo(void)
+{
+   gi.printf("Event pool: %d entries in %d chunks (%d bytes), grown %d times\n"
+             "Pending events: %d, peak %d this level, %d this game\n",
+             eventPoolSize, numEventChunks, numEventChunks * (int)sizeof(eventchunk_t), eventPoolGrowth,
+             numEvents, peakEventsLevel, peakEventsGame);
+   gi.printf("Posted this level: %d, %d of them coalesced\n", eventsPosted, eventsCoalesced);
+
+   if(numEvents)
+   {
+      gi.printf("Events holding the most entries:\n");
+      G_PrintTopPendingEvents(10);
+   }
+}
+
+inline void Listener::LinkPendingEvent(eventcache_t *event)
+{
+   event->objprev = NULL;
+   event->objnext = pendingEvents;
+   if(pendingEvents)
+   {
+      pendingEvents->objprev = event;
+   }
+   pendingEvents = event;
+}
+
+inline void Listener::UnlinkPendingEvent(eventcache_t *event)
+{
+   if(event->objprev)
+   {
+      event->objprev->objnext = event->objnext;
+   }
+   else
+   {
+      assert(pendingEvents == event);
+      pendingEvents = event->objnext;
+   }
+
+   if(event->objnext)
+   {
+      event->objnext->objprev = event->objprev;
+   }
+
+   event->objnext = NULL;
+   event->objprev = NULL;
+}
+
+/*
+===============
+Listener::FindPendingEvent
+
+Returns the pending event that will be processed first out of this object's
+events with the specified event number (or any event when eventnum is 0) that
+are due at or before the specified time (or at any time when time is negative).
+===============
+*/
+eventcache_t *Listener::FindPendingEvent(int eventnum, float time)
 {
    eventcache_t *event;
-   int eventnum;
+   eventcache_t *found;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
+   found = NULL;
+   for(event = pendingEvents; event != NULL; event = event->objnext)
+   {
+      assert(event->obj == this);
 
-   event = EventQueue->next;
+      if(eventnum && ((int)*event->event != eventnum))
+      {
+         continue;
+      }
+
+      if((time >= 0) && (event->time > time))
+      {
+         continue;
+      }
+
+      if(!found || EventHeap::Before(event, found))
+      {
+         found = event;
+      }
+   }
+
+   return found;
+}
+
+/*
+===============
+G_ReleaseEvent
+
+Gives up the queue's use of an event.  A timer's event may also be in the
+middle of being processed, in which case ProcessEvent deletes it once it's
+done with it.
+===============
+*/
+void G_ReleaseEvent(Event *ev)
+{
+   if(ev->info.inuse)
+   {
+      ev->info.inuse--;
+   }
+
+   if(!ev->info.inuse)
+   {
+      delete ev;
+   }
+}
+
+static void G_FreePendingEvent(eventcache_t *event)
+{
+   EventQueue.Remove(event);
+   G_ReleaseEvent(event->event);
+   event->event = NULL;
+   event->obj = NULL;
+   LL_Add(FreeEvents, event, next, prev);
+   numEvents--;
+}
+
+EXPORT_FROM_DLL qboolean Listener::EventPending(Event &ev)
+{
+   eventcache_t *event;
+   int eventnum;
 
    eventnum = (int)ev;
-   while(event != EventQueue)
+   for(event = pendingEvents; event != NULL; event = event->objnext)
    {
-      if((event->obj == this) && ((int)*event->event == eventnum))
+      if((int)*event->event == eventnum)
       {
          return true;
       }
-      event = event->next;
    }
 
    return false;
@@ -1095,6 +2172,7 @@ EXPORT_FROM_DLL inline qboolean Listener::CheckEventFlags(Event *event)
 EXPORT_FROM_DLL qboolean Listener::ProcessEvent(Event *event)
 {
    const ClassDef *c;
+   Response       *response;
    int             ev;
    int             i;
 
@@ -1104,6 +2182,11 @@ EXPORT_FROM_DLL qboolean Listener::ProcessEvent(Event *event)
       gi.error("ProcessEvent : Event usage overflow on '%s' event.  Possible infinite loop.\n", event->getName().c_str());
    }
 
+   if(EventTracing)
+   {
+      G_TraceEvent(this, event);
+   }
+
    if(g_showevents->value)
    {
       int n;
@@ -1174,19 +2257,35 @@ EXPORT_FROM_DLL qboolean Listener::ProcessEvent(Event *event)
       return false;
    }
 
-   if(c->responseLookup[ev])
+   response = c->GetResponse(ev);
+   if(response)
    {
       int start;
       int end;
 
       event->info.inuse++;
 
-      if(!g_timeevents->value)
+      if(g_profileevents->value)
+      {
+         long long start;
+
+         start = G_Nanoseconds();
+
+         // only process the event if we allow it
+         if(CheckEventFlags(event))
+         {
+            (this->*(*response))(event);
+         }
+
+         // c is still valid even if the response deleted us
+         G_ProfileEvent(ev, c, G_Nanoseconds() - start);
+      }
+      else if(!g_timeevents->value)
       {
          // only process the event if we allow it
          if(CheckEventFlags(event))
          {
-            (this->**c->responseLookup[ev])(event);
+            (this->*(*response))(event);
          }
       }
       else
@@ -1196,7 +2295,7 @@ EXPORT_FROM_DLL qboolean Listener::ProcessEvent(Event *event)
          // only process the event if we allow it
          if(CheckEventFlags(event))
          {
-            (this->**c->responseLookup[ev])(event);
+            (this->*(*response))(event);
          }
 
          end = G_Milliseconds();
@@ -1228,86 +2327,264 @@ EXPORT_FROM_DLL qboolean Listener::ProcessEvent(Event *event)
    return false;
 }
 
-EXPORT_FROM_DLL void Listener::PostEvent(Event *ev, float time)
+/*
+===============
+Listener::CoalesceEvent
+
+Events flagged EV_COALESCE are only ever pending once per object.  Posting
+one while a copy is already queued replaces the queued copy and moves it to
+the new time, the same as cancelling it and posting again, but without
+giving up the queue entry.
+===============
+*/
+inline qboolean Listener::CoalesceEvent(Event *ev, float time)
 {
-   eventcache_t *newevent;
    eventcache_t *event;
+   Event        *old;
 
-   if(LoadingSavegame)
+   if(!(Event::flagList->ObjectAt(ev->eventnum) & EV_COALESCE))
    {
-      if(!ev->info.inuse)
-      {
-         delete ev;
-      }
+      return false;
+   }
 
-      return;
+   event = FindPendingEvent(ev->eventnum);
+   if(!event || event->interval)
+   {
+      return false;
    }
 
-   if(LL_Empty(FreeEvents, next, prev))
+   if(ev->info.inuse >= MAX_EVENT_USE)
    {
-      gi.error("PostEvent : No more free events on '%s' event.\n", ev->getName().c_str());
-      return;
+      gi.error("PostEvent : Event usage overflow on '%s' event.  Possible infinite loop.\n", ev->getName().c_str());
+      return false;
    }
 
-   newevent = FreeEvents->next;
-   LL_Remove(newevent, next, prev);
+   old = event->event;
+   if(old != ev)
+   {
+      ev->info.inuse++;
+      event->event = ev;
+      G_ReleaseEvent(old);
+   }
+
+   event->time = level.time + time;
+   EventQueue.Reschedule(event);
+   eventsCoalesced++;
+
+   return true;
+}
+
+/*
+===============
+Listener::QueueEvent
+
+Adds a new entry for the event to the queue.
+===============
+*/
+eventcache_t *Listener::QueueEvent(Event *ev, float time)
+{
+   eventcache_t *newevent;
+
+   if(LL_Empty(FreeEvents, next, prev) && !G_GrowEventPool())
+   {
+      gi.error("PostEvent : No more free events on '%s' event.  Raise g_eventpoolmax above %d.\n",
+               ev->getName().c_str(), eventPoolSize);
+      return NULL;
+   }
 
    // Probably don't have this many events, but it's a good safety precaution
    if(ev->info.inuse >= MAX_EVENT_USE)
    {
       gi.error("PostEvent : Event usage overflow on '%s' event.  Possible infinite loop.\n", ev->getName().c_str());
-      return;
+      return NULL;
    }
 
+   newevent = FreeEvents->next;
+   LL_Remove(newevent, next, prev);
+
    ev->info.inuse++;
 
    newevent->obj = this;
    newevent->event = ev;
    newevent->time = level.time + time;
+   newevent->interval = 0;
+
+   EventQueue.Insert(newevent);
+   LinkPendingEvent(newevent);
+   numEvents++;
 
-   event = EventQueue->next;
-   while((event != EventQueue) && (newevent->time >= event->time))
+   if(numEvents > peakEventsLevel)
    {
-      event = event->next;
+      peakEventsLevel = numEvents;
+      if(numEvents > peakEventsGame)
+      {
+         peakEventsGame = numEvents;
+      }
    }
 
-   LL_Add(event, newevent, next, prev);
-   numEvents++;
+   return newevent;
 }
 
-EXPORT_FROM_DLL qboolean Listener::PostponeEvent(Event &ev, float time)
+EXPORT_FROM_DLL void Listener::PostEvent(Event *ev, float time)
+{
+   if(LoadingSavegame)
+   {
+      if(!ev->info.inuse)
+      {
+         delete ev;
+      }
+
+      return;
+   }
+
+   eventsPosted++;
+
+   if(CoalesceEvent(ev, time))
+   {
+      return;
+   }
+
+   QueueEvent(ev, time);
+}
+
+eventcache_t *Listener::FindTimer(int eventnum)
 {
    eventcache_t *event;
-   eventcache_t *node;
-   int eventnum;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
+   for(event = pendingEvents; event != NULL; event = event->objnext)
+   {
+      if(event->interval && ((int)*event->event == eventnum))
+      {
+         return event;
+      }
+   }
 
-   eventnum = (int)ev;
+   return NULL;
+}
+
+/*
+===============
+Listener::IsTimerEvent
+
+Returns true if event is the one a timer on this object is processing, so
+handlers can tell a tick of their own timer from a fresh request.
+===============
+*/
+EXPORT_FROM_DLL qboolean Listener::IsTimerEvent(Event *event)
+{
+   eventcache_t *timer;
+
+   timer = FindTimer((int)*event);
+   return (timer && (timer->event == event));
+}
+
+/*
+===============
+Listener::Schedule
+
+Posts an event that's processed every interval seconds, starting interval
+seconds from now, until it's cancelled with CancelEventsOfType or the object
+is removed.  The timer keeps its place in the pool and its event between
+ticks.  There's only ever one timer for an event on an object, so scheduling
+it again changes the interval and restarts it.  When repeat is false, this
+is just PostEvent.
+===============
+*/
+EXPORT_FROM_DLL void Listener::Schedule(Event *ev, float interval, qboolean repeat)
+{
+   eventcache_t *timer;
 
-   event = EventQueue->next;
-   while(event != EventQueue)
+   if(!repeat)
    {
-      if((event->obj == this) && ((int)*event->event == eventnum))
+      PostEvent(ev, interval);
+      return;
+   }
+
+   if(LoadingSavegame)
+   {
+      if(!ev->info.inuse)
       {
-         event->time += time;
+         delete ev;
+      }
 
-         node = event->next;
-         while((node != EventQueue) && (event->time >= node->time))
-         {
-            node = node->next;
-         }
+      return;
+   }
 
-         LL_Remove(event, next, prev);
-         LL_Add(node, event, next, prev);
+   assert(interval > 0);
+   if(interval <= 0)
+   {
+      ev->Error("Schedule : Interval must be greater than 0.\n");
+      if(!ev->info.inuse)
+      {
+         delete ev;
+      }
+      return;
+   }
 
-         return true;
+   timer = FindTimer((int)*ev);
+   if(!timer)
+   {
+      timer = QueueEvent(ev, interval);
+      if(timer)
+      {
+         timer->interval = interval;
       }
-      event = event->next;
+      return;
    }
 
-   return false;
+   if(timer->event != ev)
+   {
+      if(ev->info.inuse >= MAX_EVENT_USE)
+      {
+         gi.error("Schedule : Event usage overflow on '%s' event.  Possible infinite loop.\n", ev->getName().c_str());
+         return;
+      }
+
+      ev->info.inuse++;
+      G_ReleaseEvent(timer->event);
+      timer->event = ev;
+   }
+
+   timer->interval = interval;
+   timer->time = level.time + interval;
+   EventQueue.Reschedule(timer);
+}
+
+EXPORT_FROM_DLL void Listener::Schedule(Event &ev, float interval, qboolean repeat)
+{
+   eventcache_t *timer;
+
+   // reuse the timer's own event instead of copying the same one again
+   if(repeat && (interval > 0) && !LoadingSavegame && !ev.NumArgs())
+   {
+      timer = FindTimer((int)ev);
+      if(timer && !timer->event->NumArgs())
+      {
+         timer->interval = interval;
+         timer->time = level.time + interval;
+         EventQueue.Reschedule(timer);
+         return;
+      }
+   }
+
+   Schedule(new Event(ev), interval, repeat);
+}
+
+EXPORT_FROM_DLL qboolean Listener::PostponeEvent(Event &ev, float time)
+{
+   eventcache_t *event;
+
+   // postpone the earliest matching event, the same one a walk of the queue would find
+   event = FindPendingEvent((int)ev);
+   if(!event)
+   {
+      return false;
+   }
+
+   event->time += time;
+   EventQueue.Reschedule(event);
+
+   return true;
 }
 
 EXPORT_FROM_DLL void Listener::CancelEventsOfType(Event *ev)
@@ -1316,49 +2593,26 @@ EXPORT_FROM_DLL void Listener::CancelEventsOfType(Event *ev)
    eventcache_t *next;
    int eventnum;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
-
-   event = EventQueue->next;
-
    eventnum = (int)*ev;
-   while(event != EventQueue)
+   for(event = pendingEvents; event != NULL; event = next)
    {
-      next = event->next;
-      if((event->obj == this) && ((int)*event->event == eventnum))
+      next = event->objnext;
+      if((int)*event->event == eventnum)
       {
-         delete event->event;
-         event->event = NULL;
-         LL_Remove(event, next, prev);
-         LL_Add(FreeEvents, event, next, prev);
-         numEvents--;
+         UnlinkPendingEvent(event);
+         G_FreePendingEvent(event);
       }
-      event = next;
    }
 }
 
 EXPORT_FROM_DLL void Listener::CancelPendingEvents(void)
 {
    eventcache_t *event;
-   eventcache_t *next;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
-
-   event = EventQueue->next;
-
-   while(event != EventQueue)
+   while((event = pendingEvents) != NULL)
    {
-      next = event->next;
-      if(event->obj == this)
-      {
-         delete event->event;
-         event->event = NULL;
-         LL_Remove(event, next, prev);
-         LL_Add(FreeEvents, event, next, prev);
-         numEvents--;
-      }
-      event = next;
+      UnlinkPendingEvent(event);
+      G_FreePendingEvent(event);
    }
 }
 
@@ -1367,52 +2621,45 @@ EXPORT_FROM_DLL qboolean Listener::ProcessPendingEvents(void)
    eventcache_t *event;
    qboolean processedEvents;
    float t;
-
-   assert(EventQueue);
-   assert(EventQueue->next);
-   assert(EventQueue->prev);
+   SafePtr<Listener> self;
 
    processedEvents = false;
 
    t = level.time + 0.001;
 
-   event = EventQueue->next;
-   while(event != EventQueue)
+   // we may be removed by one of our events
+   self = this;
+
+   // Only our own events are searched, so we can look again after each one rather than
+   // worrying about what processing the event may have done to the rest of the queue.
+   while(self && ((event = FindPendingEvent(0, t)) != NULL))
    {
-      assert(event);
       assert(event->event);
-      assert(event->obj);
 
-      if(event->time > t)
+      if(event->interval)
       {
-         break;
+         // timers stay queued with the same event, so just move them along before processing it
+         event->time = level.time + event->interval;
+         EventQueue.Reschedule(event);
+         ProcessEvent(event->event);
+         processedEvents = true;
+         continue;
       }
 
-      if(event->obj != this)
-      {
-         // traverse normally
-         event = event->next;
-      }
-      else
-      {
-         LL_Remove(event, next, prev);
-         numEvents--;
-
-         assert(event->obj);
-
-         // ProcessEvent increments the inuse count, so decrement it since we've already incremented it in PostEvent
-         event->event->info.inuse--;
+      EventQueue.Remove(event);
+      UnlinkPendingEvent(event);
+      numEvents--;
 
-         event->obj->ProcessEvent(event->event);
+      // ProcessEvent increments the inuse count, so decrement it since we've already incremented it in PostEvent
+      event->event->info.inuse--;
 
-         event->event = NULL;
-         LL_Add(FreeEvents, event, next, prev);
+      event->obj->ProcessEvent(event->event);
 
-         // start over, since can't guarantee that we didn't process any previous or following events
-         event = EventQueue->next;
+      event->event = NULL;
+      event->obj = NULL;
+      LL_Add(FreeEvents, event, next, prev);
 
-         processedEvents = true;
-      }
+      processedEvents = true;
    }
 
    return processedEvents;
@@ -1423,21 +2670,31 @@ EXPORT_FROM_DLL Listener::~Listener()
    CancelPendingEvents();
 }
 
-EXPORT_FROM_DLL void G_ClearEventList(void)
+// Detaches any events still in the queue from the objects they belong to so
+// that those objects don't reference the nodes once the queue is reset.
+EXPORT_FROM_DLL void G_ResetEventQueue(void)
 {
+   eventcache_t *event;
    int i;
-   eventcache_t *e;
-
-   LL_Reset(FreeEvents, next, prev);
-   LL_Reset(EventQueue, next, prev);
-   memset(Events, 0, sizeof(Events));
+   int n;
 
-   for(e = &Events[0], i = 0; i < MAX_EVENTS; i++, e++)
+   n = EventQueue.NumEvents();
+   for(i = 0; i < n; i++)
    {
-      LL_Add(FreeEvents, e, next, prev);
+      event = EventQueue.NodeAt(i);
+      if(event->obj)
+      {
+         event->obj->pendingEvents = NULL;
+      }
    }
 
-   numEvents = 0;
+   EventQueue.Reset();
+}
+
+EXPORT_FROM_DLL void G_ClearEventList(void)
+{
+   G_ResetEventQueue();
+   G_ResetEventPool(g_eventpoolshrink->value != 0);
 }
 
 EXPORT_FROM_DLL void G_ProcessPendingEvents(void)
@@ -1447,19 +2704,12 @@ EXPORT_FROM_DLL void G_ProcessPendingEvents(void)
    int num;
    int maxevents;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
-   assert(EventQueue->prev);
-
    maxevents = (int)g_eventlimit->value;
 
    num = 0;
    t = level.time + 0.001;
-   while(!LL_Empty(EventQueue, next, prev))
+   while((event = EventQueue.Top()) != NULL)
    {
-      event = EventQueue->next;
-
-      assert(event);
       assert(event->event);
       assert(event->obj);
 
@@ -1468,19 +2718,29 @@ EXPORT_FROM_DLL void G_ProcessPendingEvents(void)
          break;
       }
 
-      LL_Remove(event, next, prev);
-      numEvents--;
-
-      assert(event->obj);
+      if(event->interval)
+      {
+         // timers stay queued with the same event, so just move them along before processing it
+         event->time = level.time + event->interval;
+         EventQueue.Reschedule(event);
+         event->obj->ProcessEvent(event->event);
+      }
+      else
+      {
+         EventQueue.Remove(event);
+         event->obj->UnlinkPendingEvent(event);
+         numEvents--;
 
-      // ProcessEvent increments the inuse count, so decrement it since we've already incremented it in PostEvent
-      assert(event->event->info.inuse > 0);
-      event->event->info.inuse--;
+         // ProcessEvent increments the inuse count, so decrement it since we've already incremented it in PostEvent
+         assert(event->event->info.inuse > 0);
+         event->event->info.inuse--;
 
-      event->obj->ProcessEvent(event->event);
+         event->obj->ProcessEvent(event->event);
 
-      event->event = NULL;
-      LL_Add(FreeEvents, event, next, prev);
+         event->event = NULL;
+         event->obj = NULL;
+         LL_Add(FreeEvents, event, next, prev);
+      }
 
       // Don't allow ourselves to stay in here too long.  An abnormally high number
       // of events being processed is evidence of an infinite loop of events.
@@ -1494,18 +2754,45 @@ EXPORT_FROM_DLL void G_ProcessPendingEvents(void)
    }
 }
 
+static int G_CompareEventCache(const void *arg1, const void *arg2)
+{
+   const eventcache_t *e1;
+   const eventcache_t *e2;
+
+   e1 = *(const eventcache_t **)arg1;
+   e2 = *(const eventcache_t **)arg2;
+
+   if(EventHeap::Before(e1, e2))
+   {
+      return -1;
+   }
+
+   if(EventHeap::Before(e2, e1))
+   {
+      return 1;
+   }
+
+   return 0;
+}
+
 EXPORT_FROM_DLL void G_ArchiveEvents(Archiver &arc)
 {
+   eventcache_t **sorted;
    eventcache_t *event;
    int num;
+   int n;
+   int i;
 
-   assert(EventQueue);
-   assert(EventQueue->next);
-   assert(EventQueue->prev);
+   // Write the events out in the order they'll be processed so that events
+   // posted for the same time keep their order when they're read back in.
+   n = EventQueue.NumEvents();
+   sorted = new eventcache_t *[n + 1];
 
    num = 0;
-   for(event = EventQueue->next; event != EventQueue; event = event->next)
+   for(i = 0; i < n; i++)
    {
+      event = EventQueue.NodeAt(i);
+
       assert(event);
       assert(event->event);
       assert(event->obj);
@@ -1516,54 +2803,196 @@ EXPORT_FROM_DLL void G_ArchiveEvents(Archiver &arc)
          continue;
       }
 
-      num++;
+      sorted[num++] = event;
    }
 
+   qsort((void *)sorted, (size_t)num, sizeof(eventcache_t *), G_CompareEventCache);
+
    arc.WriteInteger(num);
-   for(event = EventQueue->next; event != EventQueue; event = event->next)
+   for(i = 0; i < num; i++)
    {
-      assert(event);
-      assert(event->event);
-      assert(event->obj);
-
-      if(event->obj->isSubclassOf<Entity>() &&
-         (((Entity *)event->obj)->flags & FL_DONTSAVE))
-      {
-         continue;
-      }
+      event = sorted[i];
 
       arc.WriteObjectPointer(event->obj);
       arc.WriteEvent(*event->event);
       arc.WriteFloat(event->time);
+      arc.WriteFloat(event->interval);
    }
+
+   delete[] sorted;
 }
 
 EXPORT_FROM_DLL void G_UnarchiveEvents(Archiver &arc)
 {
    eventcache_t *e;
    int i;
+   int num;
 
-   LL_Reset(FreeEvents, next, prev);
-   LL_Reset(EventQueue, next, prev);
-   memset(Events, 0, sizeof(Events));
+   G_ResetEventQueue();
+   G_ResetEventPool(g_eventpoolshrink->value != 0);
+
+   arc.ReadInteger(&num);
+   while(eventPoolSize < num)
+   {
+      G_AddEventChunk();
+   }
 
-   arc.ReadInteger(&numEvents);
-   for(e = &Events[0], i = 0; i < numEvents; i++, e++)
+   for(i = 0; i < num; i++)
    {
+      e = FreeEvents->next;
+      LL_Remove(e, next, prev);
+
       arc.ReadObjectPointer((Class **)&e->obj);
       e->event = new Event();
       arc.ReadEvent(e->event);
       arc.ReadFloat(&e->time);
+      arc.ReadFloat(&e->interval);
 
-      LL_Add(EventQueue, e, next, prev);
+      // events were archived in order, so inserting them in turn preserves the order
+      EventQueue.Insert(e);
    }
 
-   for(; i < MAX_EVENTS; i++, e++)
+   numEvents = num;
+   peakEventsLevel = num;
+}
+
+/*
+===============
+G_LinkPendingEvents
+
+The object pointers of unarchived events aren't valid until the archive
+fixes them up when it's closed, so the events are added to their objects'
+pending lists once the level has been read in.
+===============
+*/
+EXPORT_FROM_DLL void G_LinkPendingEvents(void)
+{
+   eventcache_t *event;
+   int i;
+   int n;
+
+   n = EventQueue.NumEvents();
+   for(i = 0; i < n; i++)
    {
-      LL_Add(FreeEvents, e, next, prev);
+      event = EventQueue.NodeAt(i);
+
+      assert(event->obj);
+      if(event->obj && !event->objprev && (event->obj->pendingEvents != event))
+      {
+         event->obj->LinkPendingEvent(event);
+      }
    }
 }
 
+/*
+===============
+G_EventQueueBenchmark
+
+Posts and then drains the specified number of events through both the event
+heap and the sorted list it replaced, and reports the time each took.  Times
+are spread over a few seconds of frames so that there are plenty of events
+sharing the same time, and the order the events come out in is compared to
+make sure the heap keeps the same ordering as the list.  Inserting into the
+list is O(n^2), so it's skipped above EVENTBENCH_MAX_LIST events to keep the
+server from hanging.
+===============
+*/
+#define EVENTBENCH_MAX_LIST 10000
+
+EXPORT_FROM_DLL void G_EventQueueBenchmark(int count)
+{
+   eventcache_t *listnodes;
+   eventcache_t *heapnodes;
+   eventcache_t  listhead;
+   eventcache_t *event;
+   eventcache_t *node;
+   EventHeap     heap;
+   int          *order;
+   clock_t       start;
+   clock_t       listtime;
+   clock_t       heaptime;
+   qboolean      ordered;
+   qboolean      uselist;
+   int           i;
+
+   if(count <= 0)
+   {
+      return;
+   }
+
+   uselist = (count <= EVENTBENCH_MAX_LIST);
+
+   listnodes = new eventcache_t[count];
+   heapnodes = new eventcache_t[count];
+   order     = new int[count];
+
+   for(i = 0; i < count; i++)
+   {
+      memset(&listnodes[i], 0, sizeof(eventcache_t));
+      listnodes[i].time = (float)(rand() % 50) * FRAMETIME;
+      listnodes[i].heapindex = -1;
+      heapnodes[i] = listnodes[i];
+   }
+
+   // the sorted list
+   start = clock();
+   LL_Reset(&listhead, next, prev);
+   for(i = 0; uselist && (i < count); i++)
+   {
+      node = &listnodes[i];
+      event = listhead.next;
+      while((event != &listhead) && (node->time >= event->time))
+      {
+         event = event->next;
+      }
+
+      LL_Add(event, node, next, prev);
+   }
+
+   for(i = 0; !LL_Empty(&listhead, next, prev); i++)
+   {
+      event = listhead.next;
+      LL_Remove(event, next, prev);
+      order[i] = event - listnodes;
+   }
+   listtime = clock() - start;
+
+   // the event heap
+   ordered = true;
+   start = clock();
+   heap.Resize(count);
+   for(i = 0; i < count; i++)
+   {
+      heap.Insert(&heapnodes[i]);
+   }
+
+   for(i = 0; (event = heap.Top()) != NULL; i++)
+   {
+      heap.Remove(event);
+      if(uselist && (order[i] != (event - heapnodes)))
+      {
+         ordered = false;
+      }
+   }
+   heaptime = clock() - start;
+
+   if(uselist)
+   {
+      gi.printf("%7d events : list %9.2f ms   heap %7.2f ms   order %s\n", count,
+                (float)listtime * 1000.0f / CLOCKS_PER_SEC, (float)heaptime * 1000.0f / CLOCKS_PER_SEC,
+                ordered ? "matches" : "DIFFERS");
+   }
+   else
+   {
+      gi.printf("%7d events : list   skipped   heap %7.2f ms\n", count,
+                (float)heaptime * 1000.0f / CLOCKS_PER_SEC);
+   }
+
+   delete[] listnodes;
+   delete[] heapnodes;
+   delete[] order;
+}
+
 EXPORT_FROM_DLL void G_InitEvents(void)
 {
    g_numevents  = gi.cvar("g_numevents",  "0",    0);
@@ -1572,6 +3001,11 @@ EXPORT_FROM_DLL void G_InitEvents(void)
    g_timeevents = gi.cvar("g_timeevents", "0",    0);
    g_watch      = gi.cvar("g_watch",      "0",    0);
 
+   g_eventpoolmax    = gi.cvar("g_eventpoolmax",    "65536", 0);
+   g_eventpoolshrink = gi.cvar("g_eventpoolshrink", "0",     0);
+
+   G_InitEventProfile();
+
    BuildEventResponses();
    G_ClearEventList();
 
@@ -22,6 +22,7 @@
 
 class Entity;
 class ScriptVariable;
+class EventNameMap;
 
 typedef enum
 {
@@ -34,11 +35,60 @@ typedef enum
 #define EV_CONSOLE 1 // Allow entry from console
 #define EV_CHEAT   2 // Only allow entry from console if cheats are enabled
 #define EV_HIDE    4 // Hide from eventlist
+#define EV_COALESCE 8 // Posting while a copy is pending reschedules the pending copy instead
 
 #define MAX_EVENT_USE ( ( 1 << 8 ) - 1 )
 
+// Number of arguments an event can hold before it has to allocate them
+#define EVENT_INLINE_ARGS 4
+
+typedef enum
+{
+   EV_ARG_STRING,
+   EV_ARG_INTEGER,
+   EV_ARG_FLOAT,
+   EV_ARG_VECTOR,
+   EV_ARG_ENTITY,
+   EV_ARG_INTERNED,  // a token kept in the shared string table
+   EV_ARG_VARIABLE   // an interned token naming a script variable that existed when it was added
+} eventargtype_t;
+
+// Arguments added from code keep their type so that they never have to be
+// formatted as text and parsed again.  Strings and script tokens are resolved
+// through script variables when they're read, the same as they always were.
+typedef struct
+{
+   int      type;
+   union
+   {
+      int   integer;
+      float value;
+      float vector[3];
+      int   entnum;
+      struct
+      {
+         int      index;
+         unsigned serial;
+      } variable; // handle to the variable, checked before looking it up by name
+   };
+   str     *text; // the string, or the text form of a typed value once it's been asked for.
+                  // interned tokens point into the string table and aren't freed.
+} eventarg_t;
+
+// Arguments shared between copies of an event, so that an event sent to a
+// whole group doesn't have to copy its strings for each one.  Shared arguments
+// are never changed, except to fill in the text of typed values, which is the
+// same for everyone.  Adding to them gives the event its own copy first.
+typedef struct eventargblock_s
+{
+   int               refcount;
+   int               numargs;
+   eventarg_t       *args;
+} eventargblock_t;
+
 class ScriptThread;
 class Archiver;
+struct eventcache_s;
 
 class Event : public Class
 {
@@ -54,11 +104,22 @@ private:
    int               eventnum  = 0;
    EventInfo         info;
    const char       *name      = nullptr;
-   Container<str>   *data      = nullptr;
+   eventarg_t       *args      = nullptr;
+   int               numargs   = 0;
+   int               maxargs   = 0;
    int               threadnum = -1;
+   eventargblock_t  *shared    = nullptr;
+   eventarg_t        inlineargs[EVENT_INLINE_ARGS];
 
    static void       initCommandList();
 
+   eventarg_t       *NewArg(int type);
+   eventarg_t       *GetArg(int pos);
+   const char       *ArgText(eventarg_t *arg);
+   void              CopyArgs(const Event &ev);
+   void              ClearArgs();
+   void              UnshareArgs();
+
    friend class Listener;
 
    friend void G_ProcessPendingEvents();
@@ -66,22 +127,30 @@ private:
    friend void G_InitEvents();
    friend void G_ArchiveEvents(Archiver &arc);
    friend void G_UnarchiveEvents(Archiver &arc);
+   friend void G_ReleaseEvent(Event *ev);
 
    static Container<str *> *commandList;
    static Container<int>   *flagList;
    static Container<int>   *sortedList;
    static qboolean          dirtylist;
+   static EventNameMap     *nameMap;
 
    static int			compareEvents(const void *arg1, const void *arg2);
    static void			SortEventList();
+   static void			AddToNameMap(int eventnum);
    static int			FindEvent(const char *name);
    static int			FindEvent(str &name);
 
 public:
-   CLASS_PROTOTYPE(Event);
+   CLASS_PROTOTYPE_NOALLOC(Event);
+
+   void *operator    new (size_t);
+   void  operator    delete (void *);
 
    static int        NumEventCommands();
+   static const char *EventName(int eventnum);
    static void       ListCommands(const char *mask = nullptr);
+   static void       PrintAllocStats();
 
    Event();
    Event(int num); // ksh -- made public to fix compilation bugs (may no longer be necessary)
@@ -91,6 +160,8 @@ public:
    Event(str &command, int flags = -1);
    ~Event();
 
+   Event            &operator = (const Event &ev);
+
    str               getName() const;
 
    void              SetSource(eventsource_t source);
@@ -107,6 +178,7 @@ public:
 
    static Event      Find(const char *command);
    static qboolean   Exists(const char *command);
+   static int        EventNum(const char *command);
    static Event      Find(str &command);
 
    Event            &printInfo();
@@ -115,6 +187,8 @@ public:
    explicit operator const char *() const;
 
    int               NumArgs();
+   unsigned          ArgDigest();
+   void              ShareArgs();
 
    qboolean          IsVectorAt(int pos);
    qboolean          IsEntityAt(int pos);
@@ -134,7 +208,6 @@ public:
    void              AddString(const char *text);
    void              AddString(str &text);
    void              AddInteger(int val);
-   void              AddDouble(double val);
    void              AddFloat(float val);
    void              AddVector(Vector &vec);
    void              AddEntity(Entity *ent);
@@ -149,6 +222,19 @@ extern Event EV_Remove;
 class Listener : public Class
 {
 private:
+   struct eventcache_s    *pendingEvents = nullptr; // this object's entries in the event queue
+
+   void                    LinkPendingEvent(struct eventcache_s *event);
+   void                    UnlinkPendingEvent(struct eventcache_s *event);
+   struct eventcache_s    *FindPendingEvent(int eventnum, float time = -1);
+   qboolean                CoalesceEvent(Event *ev, float time);
+   struct eventcache_s    *QueueEvent(Event *ev, float time);
+   struct eventcache_s    *FindTimer(int eventnum);
+
+   friend void G_ProcessPendingEvents();
+   friend void G_ResetEventQueue();
+   friend void G_LinkPendingEvents();
+
    void                    FloatVarEvent(Event *e);
    void                    IntVarEvent(Event *e);
    void                    StringVarEvent(Event *e);
@@ -179,12 +265,19 @@ public:
    void                    PostEvent(Event &event, float time);
    qboolean                PostponeEvent(Event &event, float time);
    qboolean                PostponeEvent(Event *event, float time);
+   void                    Schedule(Event *event, float interval, qboolean repeat = true);
+   void                    Schedule(Event &event, float interval, qboolean repeat = true);
+   qboolean                IsTimerEvent(Event *event);
    void                    CancelEventsOfType(Event *event);
    void                    CancelEventsOfType(Event &event);
    void                    CancelPendingEvents();
    qboolean	               ProcessPendingEvents();
 };
 
+void G_LinkPendingEvents(void);
+void G_EventPoolInfo(void);
+void G_EventQueueBenchmark(int count);
+
 inline qboolean Event::Exists(const char *command)
 {
    int num;
@@ -206,6 +299,19 @@ inline qboolean Event::Exists(const char *command)
 }
 
 
+inline int Event::EventNum(const char *command)
+{
+   str c;
+
+   if(!commandList)
+   {
+      initCommandList();
+   }
+
+   c = command;
+   return FindEvent(c);
+}
+
 inline Event Event::Find(const char *command)
 {
    int num;
@@ -322,93 +428,95 @@ inline Event::operator const char *() const
 
 inline int Event::NumArgs()
 {
-   if(!data)
-   {
-      return 0;
-   }
-
-   return (data->NumObjects());
-}
-
-inline void Event::AddToken(const char *text)
-{
-   AddString(text);
+   return numargs;
 }
 
-inline void Event::AddTokens(int argc, const char **argv)
+inline eventarg_t *Event::NewArg(int type)
 {
-   int i;
+   eventarg_t *newargs;
+   eventarg_t *arg;
 
-   for(i = 0; i < argc; i++)
+   if(shared)
    {
-      assert(argv[i]);
-      AddString(argv[i]);
+      UnshareArgs();
    }
-}
 
-inline void Event::AddString(const char *text)
-{
-   if(!data)
+   if(!args)
    {
-      data = new Container<str>();
-      data->Resize(1);
+      args = inlineargs;
+      maxargs = EVENT_INLINE_ARGS;
    }
+   else if(numargs >= maxargs)
+   {
+      maxargs *= 2;
+      newargs = new eventarg_t[maxargs];
+      memcpy(newargs, args, sizeof(eventarg_t) * numargs);
+      if(args != inlineargs)
+      {
+         delete[] args;
+      }
+      args = newargs;
+   }
+
+   arg = &args[numargs++];
+   arg->type = type;
+   arg->text = NULL;
 
-   data->AddObject(str(text));
+   return arg;
 }
 
-inline void Event::AddString(str &text)
+inline eventarg_t *Event::GetArg(int pos)
 {
-   if(!data)
+   if((pos < 1) || (numargs < pos))
    {
-      data = new Container<str>();
-      data->Resize(1);
+      Error("Index %d out of range.", pos);
+      return NULL;
    }
 
-   data->AddObject(text);
+   return &args[pos - 1];
 }
 
-inline void Event::AddInteger(int val)
+inline void Event::AddString(const char *text)
 {
-   char text[128];
-
-   snprintf(text, sizeof(text), "%d", val);
-   AddString(text);
+   NewArg(EV_ARG_STRING)->text = new str(text);
 }
 
-inline void Event::AddDouble(double val)
+inline void Event::AddString(str &text)
 {
-   char text[128];
+   NewArg(EV_ARG_STRING)->text = new str(text);
+}
 
-   snprintf(text, sizeof(text), "%f", val);
-   AddString(text);
+inline void Event::AddInteger(int val)
+{
+   NewArg(EV_ARG_INTEGER)->integer = val;
 }
 
 inline void Event::AddFloat(float val)
 {
-   char text[128];
-
-   snprintf(text, sizeof(text), "%f", val);
-   AddString(text);
+   NewArg(EV_ARG_FLOAT)->value = val;
 }
 
 inline void Event::AddVector(Vector &vec)
 {
-   char text[128];
+   eventarg_t *arg;
 
-   snprintf(text, sizeof(text), "(%f %f %f)", vec[0], vec[1], vec[2]);
-   AddString(text);
+   arg = NewArg(EV_ARG_VECTOR);
+   arg->vector[0] = vec[0];
+   arg->vector[1] = vec[1];
+   arg->vector[2] = vec[2];
 }
 
 inline const char *Event::GetToken(int pos)
 {
-   if(!data || (pos < 1) || (data->NumObjects() < pos))
+   eventarg_t *arg;
+
+   arg = GetArg(pos);
+   if(!arg)
    {
-      Error("Index %d out of range.", pos);
       return "";
    }
 
-   return data->ObjectAt(pos).c_str();
+   return ArgText(arg);
 }
 
 inline qboolean Listener::ProcessEvent(Event &event)
@@ -817,7 +817,7 @@ RopeBase::RopeBase() : RopePiece()
 
       // allow the rope to move a bit at first
       clientinpvs = true;
-      PostEvent(EV_RopeBase_PVSCheck, 5);
+      Schedule(EV_RopeBase_PVSCheck, 5);
    }
 }
 
@@ -929,7 +929,7 @@ void RopeBase::PVSCheck(Event *ev)
    if(rope)
    {
       clientinpvs = true;
-      PostEvent(EV_RopeBase_PVSCheck, 2);
+      Schedule(EV_RopeBase_PVSCheck, 2);
       return;
    }
 
@@ -948,7 +948,7 @@ void RopeBase::PVSCheck(Event *ev)
          if(gi.inPVS(curr_piece->worldorigin.vec3(), ent->worldorigin.vec3()))
          {
             clientinpvs = true;
-            PostEvent(EV_RopeBase_PVSCheck, 2);
+            Schedule(EV_RopeBase_PVSCheck, 2);
             return;
          }
 
@@ -957,7 +957,7 @@ void RopeBase::PVSCheck(Event *ev)
    }
 
    clientinpvs = false;
-   PostEvent(EV_RopeBase_PVSCheck, 1);
+   Schedule(EV_RopeBase_PVSCheck, 1);
 }
 
 /*================================================================
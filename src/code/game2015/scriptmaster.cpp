@@ -18,6 +18,7 @@
 // 
 
 #include "g_local.h"
+#include "../elib/qstring.h"
 #include "class.h"
 #include "scriptmaster.h"
 #include "container.h"
@@ -28,6 +29,7 @@
 #include "specialfx.h"
 #include "worldspawn.h"
 #include "player.h"
+#include "scriptprofile.h"
 
 ScriptVariableList gameVars;
 ScriptVariableList levelVars;
@@ -37,7 +39,7 @@ static ScriptVariablePtr GameTime = nullptr;
 
 Event EV_ProcessCommands("processCommands");
 Event EV_Script_NewOrders("newOrders");
-Event EV_ScriptThread_Execute("execute");
+Event EV_ScriptThread_Execute("execute", EV_COALESCE);
 Event EV_ScriptThread_Callback("script_callback");
 Event EV_ScriptThread_ThreadCallback("thread_callback");
 Event EV_ScriptThread_ConsoleCallback("console_callback");
@@ -194,13 +196,218 @@ EXPORT_FROM_DLL void ScriptMaster::KillThreads()
    }
 
    Threads.FreeObjectList();
+   memset(threadHash, 0, sizeof(threadHash));
+   memset(waitHash, 0, sizeof(waitHash));
+   waitHashDirty = false;
 
    threadIndex = 0;
    currentThread = nullptr;
 }
 
+//
+// Threads are hashed by number, and threads that are waiting on another
+// thread, a console, a variable, a death or the player are hashed by what
+// they're waiting on, so waking them up only looks at the threads that might
+// care instead of every running thread.
+//
+
+static unsigned WaitHashIndex(threadwait_t type, const char *name, ScriptThread *thread)
+{
+   unsigned hash;
+
+   switch(type)
+   {
+   case WAIT_THREAD:
+      hash = (unsigned)((size_t)thread >> 4);
+      break;
+   case WAIT_CONSOLE:
+   case WAIT_VARIABLE:
+   case WAIT_DEATH:
+      hash = qstring::HashCodeCaseStatic(name);
+      break;
+   default:
+      hash = 0;
+      break;
+   }
+
+   hash ^= (unsigned)type * 2654435761u;
+   return (hash ^ (hash >> 16)) & (WAIT_HASH_SIZE - 1);
+}
+
+void ScriptMaster::AddThreadToHash(ScriptThread *thread)
+{
+   ScriptThread **bucket;
+
+   bucket = &threadHash[thread->ThreadNum() & (THREAD_HASH_SIZE - 1)];
+   thread->hashnext = *bucket;
+   *bucket = thread;
+}
+
+void ScriptMaster::RemoveThreadFromHash(ScriptThread *thread)
+{
+   ScriptThread **link;
+
+   for(link = &threadHash[thread->ThreadNum() & (THREAD_HASH_SIZE - 1)]; *link; link = &(*link)->hashnext)
+   {
+      if(*link == thread)
+      {
+         *link = thread->hashnext;
+         thread->hashnext = nullptr;
+         return;
+      }
+   }
+}
+
+/*
+====================
+ScriptMaster::LinkWaitingThread
+
+Puts the thread in the wait queue for whatever it's waiting on.  Called any
+time a thread's waitingFor* fields are set.
+====================
+*/
+EXPORT_FROM_DLL void ScriptMaster::LinkWaitingThread(ScriptThread *thread)
+{
+   ScriptThread **bucket;
+   threadwait_t   type;
+
+   UnlinkWaitingThread(thread);
+
+   // everything gets linked when the hash is rebuilt
+   if(waitHashDirty)
+   {
+      return;
+   }
+
+   type = thread->WaitType();
+   if(type == WAIT_NONE)
+   {
+      return;
+   }
+
+   switch(type)
+   {
+   case WAIT_CONSOLE:
+      bucket = &waitHash[WaitHashIndex(type, thread->WaitingOnConsole(), nullptr)];
+      break;
+   case WAIT_VARIABLE:
+      bucket = &waitHash[WaitHashIndex(type, thread->WaitingOnVariable(), nullptr)];
+      break;
+   case WAIT_DEATH:
+      bucket = &waitHash[WaitHashIndex(type, thread->WaitingOnDeath(), nullptr)];
+      break;
+   default:
+      bucket = &waitHash[WaitHashIndex(type, nullptr, thread->WaitingOnThread())];
+      break;
+   }
+
+   thread->waitnext = *bucket;
+   if(*bucket)
+   {
+      (*bucket)->waitprev = &thread->waitnext;
+   }
+   thread->waitprev = bucket;
+   *bucket = thread;
+}
+
+EXPORT_FROM_DLL void ScriptMaster::UnlinkWaitingThread(ScriptThread *thread)
+{
+   if(!thread->waitprev)
+   {
+      return;
+   }
+
+   *thread->waitprev = thread->waitnext;
+   if(thread->waitnext)
+   {
+      thread->waitnext->waitprev = thread->waitprev;
+   }
+
+   thread->waitnext = nullptr;
+   thread->waitprev = nullptr;
+}
+
+void ScriptMaster::RebuildWaitHash()
+{
+   int i;
+   int num;
+
+   memset(waitHash, 0, sizeof(waitHash));
+   waitHashDirty = false;
+
+   num = Threads.NumObjects();
+   for(i = 1; i <= num; i++)
+   {
+      Threads.ObjectAt(i)->waitprev = nullptr;
+      LinkWaitingThread(Threads.ObjectAt(i));
+   }
+}
+
+/*
+====================
+ScriptMaster::FindWaitingThreads
+
+Fills list with the threads waiting on the name or thread.  The newest
+waiters are at the front of the queue, so the list is newest first and
+callers walk it backwards.  Handles are used since waking one thread can
+end another.
+====================
+*/
+int ScriptMaster::FindWaitingThreads(threadwait_t type, const char *name, ScriptThread *thread, Container<ScriptThreadHandle> &list)
+{
+   ScriptThreadHandle  handle;
+   ScriptThread       *waiting;
+   const char         *waitname;
+
+   if(waitHashDirty)
+   {
+      RebuildWaitHash();
+   }
+
+   for(waiting = waitHash[WaitHashIndex(type, name, thread)]; waiting; waiting = waiting->waitnext)
+   {
+      if(waiting->WaitType() != type)
+      {
+         continue;
+      }
+
+      switch(type)
+      {
+      case WAIT_THREAD:
+         if(waiting->WaitingOnThread() != thread)
+         {
+            continue;
+         }
+         break;
+      case WAIT_CONSOLE:
+      case WAIT_VARIABLE:
+      case WAIT_DEATH:
+         if(type == WAIT_CONSOLE)
+            waitname = waiting->WaitingOnConsole();
+         else if(type == WAIT_VARIABLE)
+            waitname = waiting->WaitingOnVariable();
+         else
+            waitname = waiting->WaitingOnDeath();
+
+         if(strcmp(waitname, name))
+         {
+            continue;
+         }
+         break;
+      default:
+         break;
+      }
+
+      handle = waiting;
+      list.AddObject(handle);
+   }
+
+   return list.NumObjects();
+}
+
 EXPORT_FROM_DLL qboolean ScriptMaster::NotifyOtherThreads(int num)
 {
+   Container<ScriptThreadHandle> waiting;
    ScriptThread *thread1;
    ScriptThread *thread2;
    int i;
@@ -209,47 +416,50 @@ EXPORT_FROM_DLL qboolean ScriptMaster::NotifyOtherThreads(int num)
 
    thread1 = GetThread(num);
    assert(thread1);
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   n = FindWaitingThreads(WAIT_THREAD, nullptr, thread1, waiting);
+   if(!n)
    {
-      thread2 = Threads.ObjectAt(i);
-      assert(thread2);
-      if(thread2->WaitingOnThread() == thread1)
-      {
-         ev = new Event(EV_ScriptThread_ThreadCallback);
-         ev->SetThread(thread1);
-         thread2->ProcessEvent(ev);
+      return false;
+   }
 
-         return true;
+   // only the first thread to wait gets told.  The others stay waiting, but
+   // take them out of the queue so they don't get woken by whatever thread
+   // ends up at the same address.
+   for(i = n - 1; i > 0; i--)
+   {
+      thread2 = waiting.ObjectAt(i);
+      if(thread2)
+      {
+         UnlinkWaitingThread(thread2);
       }
    }
-   return false;
+
+   thread2 = waiting.ObjectAt(n);
+   if(thread2)
+   {
+      ev = new Event(EV_ScriptThread_ThreadCallback);
+      ev->SetThread(thread1);
+      thread2->ProcessEvent(ev);
+   }
+
+   return true;
 }
 
 EXPORT_FROM_DLL void ScriptMaster::DeathMessage(const char *name)
 {
+   Container<ScriptThreadHandle> waiting;
    ScriptThread         *thread;
    Event                *ev;
-   int                  i, n;
+   int                  i;
 
    // Look for threads that are waiting for this name
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   for(i = FindWaitingThreads(WAIT_DEATH, name, nullptr, waiting); i > 0; i--)
    {
-      const char *waiting;
-      thread = Threads.ObjectAt(i);
-      assert(thread);
+      thread = waiting.ObjectAt(i);
       if(thread)
       {
-         waiting = thread->WaitingOnDeath();
-         if(waiting)
-         {
-            if(!strcmp(waiting, name))
-            {
-               ev = new Event(EV_ScriptThread_DeathCallback);
-               thread->ProcessEvent(ev);
-            }
-         }
+         ev = new Event(EV_ScriptThread_DeathCallback);
+         thread->ProcessEvent(ev);
       }
    }
 }
@@ -266,23 +476,19 @@ EXPORT_FROM_DLL void ScriptMaster::PlayerNotReady()
 
 EXPORT_FROM_DLL void ScriptMaster::PlayerSpawned()
 {
+   Container<ScriptThreadHandle> waiting;
    ScriptThread         *thread;
-   int                  i, n;
+   int                  i;
 
    player_ready = true;
    // Look for threads that are waiting for the player
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   for(i = FindWaitingThreads(WAIT_PLAYER, nullptr, nullptr, waiting); i > 0; i--)
    {
-      thread = Threads.ObjectAt(i);
-      assert(thread);
+      thread = waiting.ObjectAt(i);
       if(thread)
       {
-         if(thread->WaitingOnPlayer())
-         {
-            thread->ClearWaitFor();
-            thread->Start(game.maxclients > 1 && level.cinematic ? cinemadelay->value : -1);
-         }
+         thread->ClearWaitFor();
+         thread->Start(game.maxclients > 1 && level.cinematic ? cinemadelay->value : -1);
       }
    }
 }
@@ -317,11 +523,12 @@ EXPORT_FROM_DLL void ScriptMaster::CreateConsoleUser(const char *console_name, i
 
 EXPORT_FROM_DLL void ScriptMaster::ConsoleVariable(const char *name, const char *text)
 {
+   Container<ScriptThreadHandle> waiting;
    ScriptThread        *thread;
    ScriptVariable      *var;
    ScriptVariableList  *vars;
    Event               *ev;
-   int                  i, n;
+   int                  i;
    const char          *v;
    char                 varname[256];
 
@@ -346,36 +553,25 @@ EXPORT_FROM_DLL void ScriptMaster::ConsoleVariable(const char *name, const char
    }
 
    // Look for threads that are waiting for this variable
-
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   for(i = FindWaitingThreads(WAIT_VARIABLE, name, nullptr, waiting); i > 0; i--)
    {
-      const char *waiting;
-
-      thread = Threads.ObjectAt(i);
-      assert(thread);
+      thread = waiting.ObjectAt(i);
       if(thread)
       {
-         waiting = thread->WaitingOnVariable();
-         if(waiting)
-         {
-            if(!strcmp(waiting, name))
-            {
-               ev = new Event(EV_ScriptThread_VariableCallback);
-               thread->ProcessEvent(ev);
-            }
-         }
+         ev = new Event(EV_ScriptThread_VariableCallback);
+         thread->ProcessEvent(ev);
       }
    }
 }
 
 EXPORT_FROM_DLL void ScriptMaster::ConsoleInput(const char *name, const char *text)
 {
+   Container<ScriptThreadHandle> waiting;
    ScriptThread         *thread;
    ScriptVariable	      *var;
    ScriptVariableList	*vars;
    Event                *ev;
-   int                  i, n;
+   int                  i;
    const char				*v;
    char                 varname[256];
 
@@ -401,24 +597,13 @@ EXPORT_FROM_DLL void ScriptMaster::ConsoleInput(const char *name, const char *te
 
    // Look for threads that are waiting for input from
    // this console.
-
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   for(i = FindWaitingThreads(WAIT_CONSOLE, name, nullptr, waiting); i > 0; i--)
    {
-      const char *waiting;
-      thread = Threads.ObjectAt(i);
-      assert(thread);
+      thread = waiting.ObjectAt(i);
       if(thread)
       {
-         waiting = thread->WaitingOnConsole();
-         if(waiting)
-         {
-            if(!strcmp(waiting, name))
-            {
-               ev = new Event(EV_ScriptThread_ConsoleCallback);
-               thread->ProcessEvent(ev);
-            }
-         }
+         ev = new Event(EV_ScriptThread_ConsoleCallback);
+         thread->ProcessEvent(ev);
       }
    }
 }
@@ -446,27 +631,19 @@ EXPORT_FROM_DLL qboolean ScriptMaster::KillThread(int num)
 EXPORT_FROM_DLL qboolean ScriptMaster::RemoveThread(int num)
 {
    ScriptThread *thread;
-   int i;
-   int n;
 
    // Must be safely reentryable so that the thread destructor can tell us that it's being deleted.
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   thread = GetThread(num);
+   if(thread)
    {
-      thread = Threads.ObjectAt(i);
-      assert(thread);
-      if(thread)
+      RemoveThreadFromHash(thread);
+      UnlinkWaitingThread(thread);
+      Threads.RemoveObject(thread);
+      if(currentThread == thread)
       {
-         if(thread->ThreadNum() == num)
-         {
-            Threads.RemoveObjectAt(i);
-            if(currentThread == thread)
-            {
-               SetCurrentThread(NULL);
-            }
-            return true;
-         }
+         SetCurrentThread(NULL);
       }
+      return true;
    }
 
    return false;
@@ -486,6 +663,7 @@ EXPORT_FROM_DLL ScriptThread *ScriptMaster::CreateThread(GameScript *scr, const
 {
    ScriptThread *thread;
    int threadnum;
+   qboolean result;
 
    thread = new ScriptThread();
 
@@ -493,7 +671,10 @@ EXPORT_FROM_DLL ScriptThread *ScriptMaster::CreateThread(GameScript *scr, const
    threadnum = GetUniqueThreadNumber();
    Threads.AddObject(thread);
 
-   if(!thread->Setup(threadnum, scr, label))
+   // Setup sets the thread number before anything that can fail
+   result = thread->Setup(threadnum, scr, label);
+   AddThreadToHash(thread);
+   if(!result)
    {
       KillThread(threadnum);
       return nullptr;
@@ -521,21 +702,13 @@ EXPORT_FROM_DLL ScriptThread *ScriptMaster::CreateThread(const char *name, scrip
 
 EXPORT_FROM_DLL ScriptThread *ScriptMaster::GetThread(int num)
 {
-   int i;
-   int n;
    ScriptThread *thread;
 
-   n = Threads.NumObjects();
-   for(i = 1; i <= n; i++)
+   for(thread = threadHash[num & (THREAD_HASH_SIZE - 1)]; thread; thread = thread->hashnext)
    {
-      thread = Threads.ObjectAt(i);
-      assert(thread);
-      if(thread)
+      if(thread->ThreadNum() == num)
       {
-         if(thread->ThreadNum() == num)
-         {
-            return thread;
-         }
+         return thread;
       }
    }
 
@@ -567,90 +740,141 @@ EXPORT_FROM_DLL qboolean ScriptMaster::Goto(GameScript *scr, const char *name)
    return scr->Goto(name);
 }
 
-EXPORT_FROM_DLL ScriptVariableList *ScriptMaster::GetVarGroup(const char *name)
+/*
+====================
+ScriptMaster::GetVarGroup
+
+Works out the variable group from the prefix of name, and points varname at
+the rest of it.  This is called for nearly every event argument read from a
+script, so the groups are told apart by length and first letter instead of
+copying out the prefix.
+====================
+*/
+EXPORT_FROM_DLL ScriptVariableList *ScriptMaster::GetVarGroup(const char *name, const char **varname)
 {
    ScriptVariableList *vars;
    const char *v;
-   char	vargroup[20];
-   int	len;
 
-   v = strchr(name, '.');
-   if(!v)
+   switch(name[0])
    {
+   case 'g':
+   case 'l':
+   case 'p':
+   case 'c':
+      break;
+
+   default:
+      // can't be a variable
       return nullptr;
    }
 
-   len = v - name;
-   if(len > sizeof(vargroup) - 1)
+   v = strchr(name, '.');
+   if(!v)
    {
-      len = sizeof(vargroup) - 1;
+      return nullptr;
    }
-   memset(vargroup, 0, sizeof(vargroup));
-   strncpy(vargroup, name, len);
 
    vars = nullptr;
-   if(!strcmp(vargroup, "game"))
-   {
-      vars = &gameVars;
-   }
-   else if(!strcmp(vargroup, "level"))
-   {
-      vars = &levelVars;
-   }
-   else if(!strcmp(vargroup, "local") && currentThread)
+   switch(v - name)
    {
-      vars = currentThread->Vars();
-   }
-   else if(!strcmp(vargroup, "parm"))
-   {
-      vars = &parmVars;
+   case 4:
+      if(!strncmp(name, "game", 4))
+      {
+         vars = &gameVars;
+      }
+      else if(!strncmp(name, "parm", 4))
+      {
+         vars = &parmVars;
+      }
+      break;
+
+   case 5:
+      if(!strncmp(name, "level", 5))
+      {
+         vars = &levelVars;
+      }
+      else if(!strncmp(name, "local", 5) && currentThread)
+      {
+         vars = currentThread->Vars();
+      }
+      break;
+
+   case 7:
+      if(!strncmp(name, "console", 7))
+      {
+         vars = &consoleVars;
+      }
+      break;
    }
-   else if(!strcmp(vargroup, "console"))
+
+   if(varname)
    {
-      vars = &consoleVars;
+      *varname = v + 1;
    }
 
    return vars;
 }
 
+EXPORT_FROM_DLL ScriptVariableList *ScriptMaster::GetVarGroup(const char *name)
+{
+   return GetVarGroup(name, nullptr);
+}
+
 EXPORT_FROM_DLL ScriptVariable *ScriptMaster::GetExistingVariable(const char *name)
 {
-   ScriptVariableList	*vars;
-   const char				*v;
+   ScriptVariableList *vars;
+   const char         *v;
 
-   vars = GetVarGroup(name);
+   vars = GetVarGroup(name, &v);
    if(!vars)
    {
       return nullptr;
    }
 
-   v = strchr(name, '.');
-   if(!v)
+   return vars->GetVariable(v);
+}
+
+EXPORT_FROM_DLL ScriptVariable *ScriptMaster::GetVariable(const char *name)
+{
+   ScriptVariable     *var;
+   ScriptVariableList *vars;
+   const char         *v;
+
+   vars = GetVarGroup(name, &v);
+   if(!vars)
    {
       return nullptr;
    }
 
-   return vars->GetVariable(v + 1);
+   var = vars->GetVariable(v);
+   if(!var)
+   {
+      var = vars->CreateVariable(v, "");
+   }
+
+   return var;
 }
 
-EXPORT_FROM_DLL ScriptVariable *ScriptMaster::GetVariable(const char *name)
+/*
+====================
+ScriptMaster::BindVariable
+
+Returns the variable, looking it up by name only if handle no longer refers
+to it.  Only for variables outside the local group, since those belong to
+whichever thread is running.
+====================
+*/
+EXPORT_FROM_DLL ScriptVariable *ScriptMaster::BindVariable(ScriptVariableHandle &handle, const char *name)
 {
-   ScriptVariable			*var;
-   ScriptVariableList	*vars;
-   const char *v;
+   ScriptVariable *var;
 
-   var = GetExistingVariable(name);
+   assert(strncmp(name, "local.", 6));
+
+   var = handle;
    if(!var)
    {
-      vars = GetVarGroup(name);
-      if(!vars)
-      {
-         return nullptr;
-      }
-
-      v = strchr(name, '.');
-      assert(v);
-      var = vars->CreateVariable(v + 1, "");
+      var = GetVariable(name);
+      handle = var;
    }
 
    return var;
@@ -769,12 +993,17 @@ ScriptThread::ScriptThread() : Listener()
 
 ScriptThread::~ScriptThread()
 {
+   Director.UnlinkWaitingThread(this);
    Director.NotifyOtherThreads(threadNum);
    Director.RemoveThread(threadNum);
+
+   delete[] updateBits;
 }
 
 EXPORT_FROM_DLL void ScriptThread::ClearWaitFor()
 {
+   Director.UnlinkWaitingThread(this);
+
    waitUntil          = 0;
    waitingFor         = "";
    waitingNumObjects  = 0;
@@ -840,6 +1069,32 @@ EXPORT_FROM_DLL qboolean ScriptThread::WaitingOnPlayer()
    return waitingForPlayer;
 }
 
+EXPORT_FROM_DLL threadwait_t ScriptThread::WaitType()
+{
+   if(waitingForThread)
+   {
+      return WAIT_THREAD;
+   }
+   else if(waitingForConsole.length())
+   {
+      return WAIT_CONSOLE;
+   }
+   else if(waitingForVariable.length())
+   {
+      return WAIT_VARIABLE;
+   }
+   else if(waitingForDeath.length())
+   {
+      return WAIT_DEATH;
+   }
+   else if(waitingForPlayer)
+   {
+      return WAIT_PLAYER;
+   }
+
+   return WAIT_NONE;
+}
+
 EXPORT_FROM_DLL ScriptVariableList *ScriptThread::Vars()
 {
    return &localVars;
@@ -946,6 +1201,7 @@ EXPORT_FROM_DLL void ScriptThread::Restore(ThreadMarker *mark)
    waitingForDeath    = mark->waitingForDeath;
    waitingForPlayer   = mark->waitingForPlayer;
    waitingNumObjects  = mark->waitingNumObjects;
+   Director.LinkWaitingThread(this);
 
    script.Restore(&mark->scriptmarker);
 
@@ -961,24 +1217,12 @@ EXPORT_FROM_DLL void ScriptThread::Restore(ThreadMarker *mark)
 
 EXPORT_FROM_DLL TargetList *ScriptThread::GetTargetList(str &targetname)
 {
-   TargetList *tlist;
-   int num;
-   int i;
-
-   num = targets.NumObjects();
-   for(i = 1; i <= num; i++)
-   {
-      tlist = targets.ObjectAt(i);
-      if(targetname == tlist->targetname)
-      {
-         return tlist;
-      }
-   }
-
-   tlist = world->GetTargetList(targetname);
-   targets.AddObject(tlist);
+   return world->GetTargetList(targetname);
+}
 
-   return tlist;
+EXPORT_FROM_DLL TargetList *ScriptThread::GetTargetList(const char *targetname)
+{
+   return world->GetTargetList(targetname);
 }
 
 EXPORT_FROM_DLL void ScriptThread::SendCommandToSlaves(const char *name, Event *ev)
@@ -991,7 +1235,11 @@ EXPORT_FROM_DLL void ScriptThread::SendCommandToSlaves(const char *name, Event *
 
    if(name && name[0])
    {
-      tlist = GetTargetList(str(name + 1));
+      tlist = GetTargetList(name + 1);
+
+      // every slave gets the same arguments, so the copies share them
+      ev->ShareArgs();
+
       num = tlist->list.NumObjects();
       for(i = 1; i <= num; i++)
       {
@@ -1001,10 +1249,8 @@ EXPORT_FROM_DLL void ScriptThread::SendCommandToSlaves(const char *name, Event *
 
          sendevent = new Event(*ev);
 
-         if(!updateList.ObjectInList(ent->entnum))
+         if(AddToUpdateList(ent->entnum))
          {
-            updateList.AddObject(ent->entnum);
-
             // Tell the object that we're about to send it some orders
             ent->ProcessEvent(EV_Script_NewOrders);
          }
@@ -1188,6 +1434,70 @@ EXPORT_FROM_DLL void ScriptThread::ProcessCommand(int argc, const char **argv)
    }
 }
 
+// Builds the event for a compiled statement.  Integer literals are added as
+// integers so they don't need to be parsed again when they're read.
+EXPORT_FROM_DLL Event *ScriptThread::StatementEvent(const scriptop_t *op, int firstarg, const char *target)
+{
+   Event *event;
+   int    i;
+
+   event = new Event(op->event);
+   event->SetSource(EV_FROM_SCRIPT);
+   event->SetThread(this);
+   event->SetLineNumber(linenumber);
+   if(target)
+   {
+      event->AddToken(target);
+   }
+
+   for(i = firstarg; i < op->argc; i++)
+   {
+      if(op->intargs & (1 << i))
+      {
+         event->AddInteger(op->values[i]);
+      }
+      else
+      {
+         event->AddToken(op->argv[i]);
+      }
+   }
+
+   return event;
+}
+
+// Same as ProcessCommand, but with the command already looked up
+EXPORT_FROM_DLL void ScriptThread::ProcessStatement(const scriptop_t *op)
+{
+   switch(op->opcode)
+   {
+   case SOP_LABEL:
+      break;
+
+   case SOP_GLOBAL:
+      if(!ProcessEvent(StatementEvent(op, 1)))
+      {
+         ScriptError("Invalid global command '%s'\n", op->argv[0]);
+      }
+      break;
+
+   case SOP_OBJECT:
+      SendCommandToSlaves(op->argv[0], StatementEvent(op, 2));
+      break;
+
+   case SOP_SURFACE:
+      surfaceManager.ProcessEvent(StatementEvent(op, 2, &op->argv[0][1]));
+      break;
+
+   case SOP_CONSOLE:
+      consoleManager.ProcessEvent(StatementEvent(op, 2, &op->argv[0][1]));
+      break;
+
+   default:
+      ProcessCommand(op->argc, op->argv);
+      break;
+   }
+}
+
 EXPORT_FROM_DLL void ScriptThread::ProcessCommandFromEvent(Event *ev, int startarg)
 {
    int			argc;
@@ -1222,13 +1532,24 @@ EXPORT_FROM_DLL void ScriptThread::ProcessCommandFromEvent(Event *ev, int starta
 
 EXPORT_FROM_DLL void ScriptThread::Start(float delay)
 {
-   CancelEventsOfType(EV_ScriptThread_Execute);
+   // execute is coalesced, so posting it replaces any pending one
    if(delay < 0)
+   {
+      CancelEventsOfType(EV_ScriptThread_Execute);
       ProcessEvent(EV_ScriptThread_Execute);
+   }
    else
+   {
       PostEvent(EV_ScriptThread_Execute, delay);
+   }
 }
 
+// Variables Execute sets every time it runs
+static ScriptVariableHandle levelPlaytime;
+static ScriptVariableHandle gamePlaytime;
+static ScriptVariableHandle parmCurrentThread;
+static ScriptVariableHandle parmPreviousThread;
+
 EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
 {
    int num;
@@ -1237,12 +1558,28 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
    const char *argv[MAX_COMMANDS];
    char args[MAX_COMMANDS][MAXTOKEN];
    ScriptVariable	*var;
+   const scriptop_t *op;
+   qboolean profiling;
+   long long threadstart;
+   long long start;
+   char profilefile[MAX_QPATH];
+   str profilethread;
 
    if(threadDying)
    {
       return;
    }
 
+   profiling = g_profilescripts->value != 0;
+   threadstart = 0;
+   start = 0;
+   if(profiling)
+   {
+      // we may not be around by the time we're done
+      profilethread = threadName;
+      threadstart = G_Nanoseconds();
+   }
+
    // set the current game time
    if(!GameTime)
    {
@@ -1251,12 +1588,12 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
 
    GameTime->setFloatValue(level.time);
 
-   levelVars.SetVariable("playtime", level.playtime);
-   gameVars.SetVariable("playtime", game.playtime);
+   Director.BindVariable(levelPlaytime, "level.playtime")->setIntValue(level.playtime);
+   Director.BindVariable(gamePlaytime, "game.playtime")->setIntValue(game.playtime);
 
    // clear the updateList so that all objects moved this frame are notified before they receive any commands
    // we have to do this here as well as in DoMove, since DoMove may not be called
-   updateList.ClearObjectList();
+   ClearUpdateList();
 
    oldthread = Director.CurrentThread();
    Director.SetCurrentThread(this);
@@ -1269,7 +1606,7 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
 
    ClearWaitFor();
 
-   var = Director.GetVariable("parm.previousthread");
+   var = Director.BindVariable(parmPreviousThread, "parm.previousthread");
    if(oldthread)
    {
       var->setIntValue(oldthread->ThreadNum());
@@ -1279,16 +1616,37 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
       var->setIntValue(0);
    }
 
-   var = Director.GetVariable("parm.currentthread");
+   var = Director.BindVariable(parmCurrentThread, "parm.currentthread");
 
    doneProcessing = false;
 
+   op = nullptr;
    num = 0;
    while((num++ < 10000) && !doneProcessing && !threadDying)
    {
       // keep our thread number up to date
       var->setIntValue(threadNum);
 
+      // run the compiled statement if we're at one
+      op = script.NextStatement(op);
+      if(op)
+      {
+         linenumber = op->line;
+         if(profiling && (op->opcode != SOP_LABEL))
+         {
+            // the statement can switch us to another script
+            Q_strlcpy(profilefile, script.Filename(), sizeof(profilefile));
+            start = G_Nanoseconds();
+            ProcessStatement(op);
+            G_ProfileScriptLine(profilefile, op->line, G_Nanoseconds() - start);
+         }
+         else
+         {
+            ProcessStatement(op);
+         }
+         continue;
+      }
+
       script.SkipNonToken(true);
 
       // save the line number for errors
@@ -1313,7 +1671,17 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
       // Ignore labels
       if(args[0][strlen(args[0]) - 1] != ':')
       {
-         ProcessCommand(argc, argv);
+         if(profiling)
+         {
+            Q_strlcpy(profilefile, script.Filename(), sizeof(profilefile));
+            start = G_Nanoseconds();
+            ProcessCommand(argc, argv);
+            G_ProfileScriptLine(profilefile, linenumber, G_Nanoseconds() - start);
+         }
+         else
+         {
+            ProcessCommand(argc, argv);
+         }
       }
    }
 
@@ -1326,8 +1694,13 @@ EXPORT_FROM_DLL void ScriptThread::Execute(Event *ev)
    Director.SetCurrentThread(oldthread);
 
    // Set the thread number on exit, in case we were called by someone who wants to know our thread
-   var = Director.GetVariable("parm.previousthread");
+   var = Director.BindVariable(parmPreviousThread, "parm.previousthread");
    var->setIntValue(threadNum);
+
+   if(profiling)
+   {
+      G_ProfileScriptThread(profilethread.c_str(), G_Nanoseconds() - threadstart);
+   }
 }
 
 EXPORT_FROM_DLL void ScriptThread::ScriptError(const char *fmt, ...)
@@ -1520,19 +1893,13 @@ void ScriptThread::EventWaitFor(Event *ev)
             {
                tent = tlist->list.ObjectAt(i);
                // add the object to the update list to make sure we tell it to do a move
-               if(!updateList.ObjectInList(tent->entnum))
-               {
-                  updateList.AddObject(tent->entnum);
-               }
+               AddToUpdateList(tent->entnum);
             }
          }
       }
 
       // add the object to the update list to make sure we tell it to do a move
-      if(!updateList.ObjectInList(ent->entnum))
-      {
-         updateList.AddObject(ent->entnum);
-      }
+      AddToUpdateList(ent->entnum);
    }
 
    DoMove();
@@ -1550,6 +1917,8 @@ void ScriptThread::EventWaitForThread(Event *ev)
       return;
    }
 
+   Director.LinkWaitingThread(this);
+
    DoMove();
 }
 
@@ -1565,6 +1934,8 @@ void ScriptThread::EventWaitForDeath(Event *ev)
       return;
    }
 
+   Director.LinkWaitingThread(this);
+
    DoMove();
 }
 
@@ -1581,6 +1952,8 @@ void ScriptThread::EventWaitForConsole(Event *ev)
       return;
    }
 
+   Director.LinkWaitingThread(this);
+
    DoMove();
 }
 
@@ -1597,6 +1970,8 @@ void ScriptThread::EventWaitForVariable(Event *ev)
       return;
    }
 
+   Director.LinkWaitingThread(this);
+
    DoMove();
 }
 
@@ -1628,6 +2003,7 @@ void ScriptThread::EventWaitForPlayer(Event *ev)
 
       ClearWaitFor();
       waitingForPlayer = true;
+      Director.LinkWaitingThread(this);
 
       DoMove();
    }
@@ -1870,6 +2246,61 @@ EXPORT_FROM_DLL void ScriptThread::DoMove()
       }
    }
 
+   ClearUpdateList();
+}
+
+/*
+====================
+ScriptThread::AddToUpdateList
+
+Adds the entity to the list of objects that get told to move, and returns
+whether it wasn't in the list already.  The bits make the check constant
+time, which matters when a command is sent to a large group.
+====================
+*/
+EXPORT_FROM_DLL qboolean ScriptThread::AddToUpdateList(int entnum)
+{
+   unsigned *newbits;
+   int       words;
+
+   if((entnum >> 5) >= updateBitWords)
+   {
+      words = ((entnum > game.maxentities) ? entnum : game.maxentities) / 32 + 1;
+      newbits = new unsigned[words];
+      memset(newbits, 0, sizeof(unsigned) * words);
+      if(updateBits)
+      {
+         memcpy(newbits, updateBits, sizeof(unsigned) * updateBitWords);
+         delete[] updateBits;
+      }
+      updateBits = newbits;
+      updateBitWords = words;
+   }
+
+   if(updateBits[entnum >> 5] & (1u << (entnum & 31)))
+   {
+      return false;
+   }
+
+   updateBits[entnum >> 5] |= 1u << (entnum & 31);
+   updateList.AddObject(entnum);
+
+   return true;
+}
+
+EXPORT_FROM_DLL void ScriptThread::ClearUpdateList()
+{
+   int entnum;
+   int i;
+   int num;
+
+   num = updateList.NumObjects();
+   for(i = 1; i <= num; i++)
+   {
+      entnum = updateList.ObjectAt(i);
+      updateBits[entnum >> 5] &= ~(1u << (entnum & 31));
+   }
+
    updateList.ClearObjectList();
 }
 
@@ -1887,7 +2318,7 @@ void ScriptThread::TriggerEvent(Event *ev)
    // Check for object commands
    if(name && name[0] == '$')
    {
-      tlist = GetTargetList(str(name + 1));
+      tlist = GetTargetList(name + 1);
       num = tlist->list.NumObjects();
       for(i = 1; i <= num; i++)
       {
@@ -36,6 +36,22 @@ typedef enum
    MODEL_SCRIPT
 } scripttype_t;
 
+// What a thread is waiting on, for the Director's wait queues.  Move done
+// and sound waits aren't queued since the mover sends EV_MoveDone straight
+// to the thread and sounds just delay the next Execute.
+typedef enum
+{
+   WAIT_NONE,
+   WAIT_THREAD,
+   WAIT_CONSOLE,
+   WAIT_VARIABLE,
+   WAIT_DEATH,
+   WAIT_PLAYER
+} threadwait_t;
+
+#define THREAD_HASH_SIZE   256
+#define WAIT_HASH_SIZE     256
+
 extern ScriptVariableList gameVars;
 extern ScriptVariableList levelVars;
 extern ScriptVariableList consoleVars;
@@ -83,6 +99,7 @@ class ScriptThread;
 template class EXPORT_FROM_DLL SafePtr<ScriptThread>;
 #endif
 typedef SafePtr<ScriptThread> ThreadPtr;
+typedef Handle<ScriptThread> ScriptThreadHandle;
 
 class ThreadMarker;
 
@@ -94,13 +111,14 @@ protected:
 
    scripttype_t            type;
    GameScript              script;
-   Container<TargetList *> targets;
 
    int                     linenumber;
    qboolean                doneProcessing;
    qboolean                threadDying;
 
    Container<int>          updateList;
+   unsigned               *updateBits     = nullptr;  // bit for each entnum in updateList
+   int                     updateBitWords = 0;
    float                   waitUntil;
    str                     waitingFor;
    ScriptThread           *waitingForThread;
@@ -111,6 +129,12 @@ protected:
    int                     waitingNumObjects;
    ScriptVariableList      localVars;
 
+   // links for the Director's thread number hash and wait queues
+   friend class ScriptMaster;
+   ScriptThread           *hashnext = nullptr;
+   ScriptThread           *waitnext = nullptr;
+   ScriptThread          **waitprev = nullptr;
+
    void                 ObjectMoveDone(Event *ev);
    void                 CreateThread(Event *ev);
    void                 TerminateThread(Event *ev);
@@ -165,6 +189,7 @@ protected:
    void                 AchievementEvent(Event *ev);
 
    TargetList           *GetTargetList(str &targetname);
+   TargetList           *GetTargetList(const char *targetname);
 
    void                 CueCamera(Event *ev);
    void                 CuePlayer(Event *ev);
@@ -224,11 +249,14 @@ public:
    int                  CurrentLine();
    const char          *Filename();
    qboolean             WaitingFor(Entity *obj);
+   qboolean             AddToUpdateList(int entnum);
+   void                 ClearUpdateList();
    ScriptThread        *WaitingOnThread();
    const char          *WaitingOnConsole();
    const char          *WaitingOnVariable();
    const char          *WaitingOnDeath();
    qboolean             WaitingOnPlayer();
+   threadwait_t         WaitType();
    ScriptVariableList  *Vars();
    qboolean             Setup(int num, GameScript *scr, const char *label);
    qboolean             SetScript(const char *name);
@@ -242,6 +270,8 @@ public:
    void                 SendCommandToSlaves(const char *name, Event *ev);
    qboolean             FindEvent(const char *name);
    void                 ProcessCommand(int argc, const char **argv);
+   Event               *StatementEvent(const scriptop_t *op, int firstarg, const char *target = nullptr);
+   void                 ProcessStatement(const scriptop_t *op);
    void                 ProcessCommandFromEvent(Event *ev, int startarg);
    virtual void         Archive(Archiver &arc)   override;
    virtual void         Unarchive(Archiver &arc) override;
@@ -257,9 +287,6 @@ inline EXPORT_FROM_DLL void ScriptThread::Archive(Archiver &arc)
 
    arc.WriteObject(&script);
 
-   // targets
-   // don't need to save out targets
-
    arc.WriteInteger(linenumber);
    arc.WriteBoolean(doneProcessing);
    arc.WriteBoolean(threadDying);
@@ -291,17 +318,13 @@ inline EXPORT_FROM_DLL void ScriptThread::Unarchive(Archiver &arc)
 
    arc.ReadObject(&script);
 
-   // targets
-   // don't need to load out targets
-   targets.ClearObjectList();
-
    arc.ReadInteger(&linenumber);
    arc.ReadBoolean(&doneProcessing);
    arc.ReadBoolean(&threadDying);
 
    // updateList
    // don't need to save out updatelist
-   updateList.ClearObjectList();
+   ClearUpdateList();
 
    arc.ReadFloat(&waitUntil);
    arc.ReadString(&waitingFor);
@@ -384,6 +407,16 @@ protected:
    int                        threadIndex   = 0;
    qboolean                   player_ready  = false;
 
+   // threads by number, and waiting threads by what they're waiting on
+   ScriptThread              *threadHash[THREAD_HASH_SIZE] = {};
+   ScriptThread              *waitHash[WAIT_HASH_SIZE] = {};
+   qboolean                   waitHashDirty = false;
+
+   void                       AddThreadToHash(ScriptThread *thread);
+   void                       RemoveThreadFromHash(ScriptThread *thread);
+   void                       RebuildWaitHash();
+   int                        FindWaitingThreads(threadwait_t type, const char *name, ScriptThread *thread, Container<ScriptThreadHandle> &list);
+
 public:
    CLASS_PROTOTYPE(ScriptMaster);
 
@@ -399,8 +432,10 @@ public:
    ScriptThread              *CreateThread(const char *name, scripttype_t type, const char *label = NULL);
    ScriptThread              *GetThread(int num);
    ScriptVariableList        *GetVarGroup(const char *name);
+   ScriptVariableList        *GetVarGroup(const char *name, const char **varname);
    ScriptVariable            *GetExistingVariable(const char *name);
    ScriptVariable            *GetVariable(const char *name);
+   ScriptVariable            *BindVariable(ScriptVariableHandle &handle, const char *name);
    void                       ConsoleInput(const char *name, const char *text);
    void                       ConsoleVariable(const char *name, const char *text);
    const char                *GetConsoleInput(const char *name);
@@ -412,6 +447,8 @@ public:
    qboolean                   Goto(GameScript * scr, const char *name);
    qboolean                   labelExists(GameScript * scr, const char *name);
    int                        GetUniqueThreadNumber();
+   void                       LinkWaitingThread(ScriptThread *thread);
+   void                       UnlinkWaitingThread(ScriptThread *thread);
    void                       FindLabels();
    virtual void               Archive(Archiver &arc)   override;
    virtual void               Unarchive(Archiver &arc) override;
@@ -455,6 +492,9 @@ inline EXPORT_FROM_DLL void ScriptMaster::Unarchive(Archiver &arc)
 
    // make sure the list is cleared out
    Threads.FreeObjectList();
+   memset(threadHash, 0, sizeof(threadHash));
+   memset(waitHash, 0, sizeof(waitHash));
+
    // read in the the number of threads
    num = arc.ReadInteger();
    for(i = 1; i <= num; i++)
@@ -462,7 +502,12 @@ inline EXPORT_FROM_DLL void ScriptMaster::Unarchive(Archiver &arc)
       ptr = new ScriptThread();
       arc.ReadObject(ptr);
       Threads.AddObject(ptr);
+      AddThreadToHash(ptr);
    }
+
+   // the threads we're waiting on haven't been fixed up yet, so the
+   // wait queues get built before they're next used
+   waitHashDirty = true;
 }
 
 extern ScriptMaster Director;
@@ -0,0 +1,246 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Script execution profiler.  While g_profilescripts is set,
+// ScriptThread::Execute times every statement it runs and hands the result to
+// G_ProfileScriptLine, and times each whole run of a thread for
+// G_ProfileScriptThread.  Times include the events the statement sends and
+// any threads it runs straight away.  Labels aren't tracked while running;
+// each line is charged to the label above it when the profile is printed.
+//
+
+#include "g_local.h"
+#include "gamescript.h"
+#include "scriptprofile.h"
+#include "../elib/qstringmap.h"
+
+cvar_t *g_profilescripts;
+
+typedef struct
+{
+   char        key[MAX_QPATH + 16];  // name and line
+   char        name[MAX_QPATH];      // file for lines, thread or label name otherwise
+   int         line;
+   int         count;
+   long long   totaltime;
+   long long   maxtime;
+} scrprofile_t;
+
+static auto profileKeyFunc = [] (scrprofile_t *prof) { return prof->key; };
+
+class ScriptProfileMap : public qstringmap<scrprofile_t *, decltype(profileKeyFunc)>
+{
+public:
+   using qstringmap::qstringmap;
+};
+
+class ScriptProfileTable
+{
+public:
+   ScriptProfileMap           map;
+   Container<scrprofile_t *>  list;
+
+   ScriptProfileTable() : map(profileKeyFunc) {}
+   ~ScriptProfileTable() { Clear(); }
+
+   scrprofile_t *Find(const char *name, int line);
+   void          Clear();
+};
+
+static ScriptProfileTable lineProfiles;
+static ScriptProfileTable threadProfiles;
+static long long          profileStart;
+
+/*
+===============
+ScriptProfileTable::Find
+
+Looks up the entry for name and line, adding it if it's new.  Names are
+truncated to MAX_QPATH, which is as long as a script's filename can be.
+===============
+*/
+scrprofile_t *ScriptProfileTable::Find(const char *name, int line)
+{
+   scrprofile_t  *prof;
+   char           key[MAX_QPATH + 16];
+
+   snprintf(key, sizeof(key), "%.*s|%d", MAX_QPATH - 1, (name && name[0]) ? name : "<none>", line);
+   prof = map.find(key);
+   if(prof)
+   {
+      return prof;
+   }
+
+   prof = new scrprofile_t;
+   memset(prof, 0, sizeof(*prof));
+   strcpy(prof->key, key);
+   Q_strlcpy(prof->name, (name && name[0]) ? name : "<none>", sizeof(prof->name));
+   prof->line = line;
+
+   map.insert(prof);
+   list.AddObject(prof);
+
+   return prof;
+}
+
+void ScriptProfileTable::Clear()
+{
+   for(scrprofile_t *prof : list)
+   {
+      delete prof;
+   }
+
+   map.clear();
+   list.FreeObjectList();
+}
+
+static void G_AddScriptProfileTime(scrprofile_t *prof, int count, long long time, long long maxtime)
+{
+   prof->count += count;
+   prof->totaltime += time;
+   if(maxtime > prof->maxtime)
+   {
+      prof->maxtime = maxtime;
+   }
+}
+
+/*
+===============
+G_ProfileScriptLine
+
+Records one run of the statement on line of filename that took time
+nanoseconds.
+===============
+*/
+EXPORT_FROM_DLL void G_ProfileScriptLine(const char *filename, int line, long long time)
+{
+   G_AddScriptProfileTime(lineProfiles.Find(filename, line), 1, time, time);
+}
+
+/*
+===============
+G_ProfileScriptThread
+
+Records one call to Execute for a thread that took time nanoseconds.
+Threads come and go, so they're kept by name (the label they were started
+at) instead of by number.
+===============
+*/
+EXPORT_FROM_DLL void G_ProfileScriptThread(const char *threadname, long long time)
+{
+   G_AddScriptProfileTime(threadProfiles.Find(threadname, 0), 1, time, time);
+}
+
+EXPORT_FROM_DLL void G_ResetScriptProfile(void)
+{
+   lineProfiles.Clear();
+   threadProfiles.Clear();
+
+   profileStart = G_Nanoseconds();
+}
+
+EXPORT_FROM_DLL void G_InitScriptProfile(void)
+{
+   g_profilescripts = gi.cvar("g_profilescripts", "0", 0);
+
+   G_ResetScriptProfile();
+}
+
+static int G_CompareScriptProfileTime(const void *arg1, const void *arg2)
+{
+   const scrprofile_t *p1 = *(scrprofile_t * const *)arg1;
+   const scrprofile_t *p2 = *(scrprofile_t * const *)arg2;
+   int                 cmp;
+
+   if(p1->totaltime != p2->totaltime)
+   {
+      return (p1->totaltime < p2->totaltime) ? 1 : -1;
+   }
+
+   cmp = strcmp(p1->name, p2->name);
+   if(cmp)
+   {
+      return cmp;
+   }
+
+   return p1->line - p2->line;
+}
+
+static void G_PrintScriptProfileTable(const char *title, ScriptProfileTable *table, qboolean lines, int num)
+{
+   const scrprofile_t *prof;
+   char                name[MAX_QPATH + 16];
+   int                 i;
+
+   // most expensive first
+   table->list.Sort(G_CompareScriptProfileTime);
+
+   gi.printf("\n%-48s %9s %12s %9s %9s\n", title, "count", "total us", "avg us", "max us");
+   for(i = 1; (i <= table->list.NumObjects()) && (i <= num); i++)
+   {
+      prof = table->list.ObjectAt(i);
+      if(lines)
+      {
+         snprintf(name, sizeof(name), "%s:%d", prof->name, prof->line);
+      }
+      else
+      {
+         Q_strlcpy(name, prof->name, sizeof(name));
+      }
+
+      gi.printf("%-48s %9d %12.1f %9.2f %9.2f\n", name, prof->count,
+                (float)((double)prof->totaltime / 1000.0),
+                (float)((double)prof->totaltime / prof->count / 1000.0),
+                (float)((double)prof->maxtime / 1000.0));
+   }
+}
+
+/*
+===============
+G_PrintScriptProfile
+
+Prints the num most expensive lines, labels and threads.
+===============
+*/
+EXPORT_FROM_DLL void G_PrintScriptProfile(int num)
+{
+   ScriptProfileTable  labels;
+   GameScript         *scr;
+   const char         *label;
+   char                name[MAX_QPATH];
+   int                 len;
+
+   if(!g_profilescripts->value)
+   {
+      gi.printf("Script profiling is off.  Set g_profilescripts 1 to turn it on.\n");
+   }
+
+   gi.printf("Profile covers %.2f seconds\n", (float)((double)(G_Nanoseconds() - profileStart) / 1000000000.0));
+
+   G_PrintScriptProfileTable("line", &lineProfiles, true, num);
+
+   // charge each line to the label above it
+   for(const scrprofile_t *prof : lineProfiles.list)
+   {
+      scr = ScriptLib.FindScript(prof->name);
+      label = scr ? scr->LabelAtLine(prof->line) : nullptr;
+      snprintf(name, sizeof(name), "%s::%s", prof->name, label ? label : "");
+      len = strlen(name);
+      if(name[len - 1] == ':')
+      {
+         name[len - 1] = 0;
+      }
+      G_AddScriptProfileTime(labels.Find(name, 0), prof->count, prof->totaltime, prof->maxtime);
+   }
+
+   G_PrintScriptProfileTable("label", &labels, false, num);
+
+   G_PrintScriptProfileTable("thread", &threadProfiles, false, num);
+}
+
+// EOF
@@ -0,0 +1,28 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Script execution profiler.  Enabled with g_profilescripts and dumped with
+// "sv scriptprofile".
+//
+
+#ifndef __SCRIPTPROFILE_H__
+#define __SCRIPTPROFILE_H__
+
+#include "g_local.h"
+
+extern cvar_t *g_profilescripts;
+
+EXPORT_FROM_DLL void G_InitScriptProfile(void);
+EXPORT_FROM_DLL void G_ResetScriptProfile(void);
+EXPORT_FROM_DLL void G_ProfileScriptLine(const char *filename, int line, long long time);
+EXPORT_FROM_DLL void G_ProfileScriptThread(const char *threadname, long long time);
+EXPORT_FROM_DLL void G_PrintScriptProfile(int num);
+
+#endif /* scriptprofile.h */
+
+// EOF
@@ -20,6 +20,15 @@
 #include "scriptmaster.h"
 #include "sentient.h" //###
 #include "weapon.h"   //###
+#include "../elib/qstringmap.h"
+
+// fast lookup of variables by name
+static auto variableKeyFunc = [] (ScriptVariable *p) { return p->getName(); };
+class ScriptVariableMap : public qstringmap<ScriptVariable *, decltype(variableKeyFunc)>
+{
+public:
+   using qstringmap::qstringmap;
+};
 
 Event EV_Var_Append("append");
 Event EV_Var_AppendInt("appendint");
@@ -165,12 +174,51 @@ EXPORT_FROM_DLL const char *ScriptVariable::getName(void)
 
 EXPORT_FROM_DLL const char *ScriptVariable::stringValue(void)
 {
+   if(textform != VAR_TEXT_VALID)
+   {
+      buildString();
+   }
+
    return string.c_str();
 }
 
+/*
+====================
+ScriptVariable::buildString
+
+Numbers and vectors are only formatted as text when something asks for the
+text, since most of them are only ever read back as numbers.
+====================
+*/
+void ScriptVariable::buildString(void)
+{
+   char text[128];
+
+   switch(textform)
+   {
+   case VAR_TEXT_INTEGER:
+      snprintf(text, sizeof(text), "%d", intvalue);
+      break;
+
+   case VAR_TEXT_FLOAT:
+      snprintf(text, sizeof(text), "%f", value);
+      break;
+
+   case VAR_TEXT_VECTOR:
+      snprintf(text, sizeof(text), "(%f %f %f)", vec.x, vec.y, vec.z);
+      break;
+
+   default:
+      return;
+   }
+
+   setString(text);
+}
+
 EXPORT_FROM_DLL void ScriptVariable::setString(const char *value)
 {
    string = value;
+   textform = VAR_TEXT_VALID;
 }
 
 EXPORT_FROM_DLL void ScriptVariable::setStringValue(const char *newvalue)
@@ -186,11 +234,9 @@ EXPORT_FROM_DLL int ScriptVariable::intValue(void)
 
 EXPORT_FROM_DLL void ScriptVariable::setIntValue(int newvalue)
 {
-   char text[128];
-
    value = (float)newvalue;
-   snprintf(text, sizeof(text), "%d", newvalue);
-   setString(text);
+   intvalue = newvalue;
+   textform = VAR_TEXT_INTEGER;
 }
 
 EXPORT_FROM_DLL float ScriptVariable::floatValue(void)
@@ -200,20 +246,14 @@ EXPORT_FROM_DLL float ScriptVariable::floatValue(void)
 
 EXPORT_FROM_DLL void ScriptVariable::setFloatValue(float newvalue)
 {
-   char text[128];
-
    value = newvalue;
-   snprintf(text, sizeof(text), "%f", newvalue);
-   setString(text);
+   textform = VAR_TEXT_FLOAT;
 }
 
 EXPORT_FROM_DLL void ScriptVariable::setVectorValue(Vector newvector)
 {
-   char text[128];
-
    vec = newvector;
-   snprintf(text, sizeof(text), "(%f %f %f)", newvector.x, newvector.y, newvector.z);
-   setString(text);
+   textform = VAR_TEXT_VECTOR;
 }
 
 EXPORT_FROM_DLL Vector ScriptVariable::vectorValue()
@@ -231,6 +271,18 @@ ResponseDef ScriptVariableList::Responses[] =
 ScriptVariableList::~ScriptVariableList()
 {
    ClearList();
+   delete map;
+}
+
+void ScriptVariableList::InsertVariable(ScriptVariable *var)
+{
+   if(!map)
+   {
+      map = new ScriptVariableMap(variableKeyFunc);
+   }
+
+   list.AddObject(var);
+   map->insert(var);
 }
 
 EXPORT_FROM_DLL void ScriptVariableList::ClearList(void)
@@ -243,11 +295,15 @@ EXPORT_FROM_DLL void ScriptVariableList::ClearList(void)
    for(i = num; i > 0; i--)
    {
       var = GetVariable(i);
-      RemoveVariable(var);
       delete var;
    }
 
    list.FreeObjectList();
+
+   if(map)
+   {
+      map->clear();
+   }
 }
 
 EXPORT_FROM_DLL void ScriptVariableList::AddVariable(ScriptVariable *var)
@@ -258,7 +314,7 @@ EXPORT_FROM_DLL void ScriptVariableList::AddVariable(ScriptVariable *var)
       return;
    }
 
-   list.AddObject(var);
+   InsertVariable(var);
 }
 
 EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *name, float value)
@@ -274,7 +330,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *n
    var = new ScriptVariable();
    var->setName(name);
    var->setFloatValue(value);
-   list.AddObject(var);
+   InsertVariable(var);
 
    return var;
 }
@@ -292,7 +348,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *n
    var = new ScriptVariable();
    var->setName(name);
    var->setIntValue(value);
-   list.AddObject(var);
+   InsertVariable(var);
 
    return var;
 }
@@ -310,7 +366,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *n
    var = new ScriptVariable();
    var->setName(name);
    var->setStringValue(text);
-   list.AddObject(var);
+   InsertVariable(var);
 
    return var;
 }
@@ -329,7 +385,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *n
 
    var = new ScriptVariable();
    var->setName(name);
-   list.AddObject(var);
+   InsertVariable(var);
 
    if(!ent)
    {
@@ -359,7 +415,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::CreateVariable(const char *n
    var = new ScriptVariable();
    var->setName(name);
    var->setStringValue(va("(%f %f %f)", vec.x, vec.y, vec.z));
-   list.AddObject(var);
+   InsertVariable(var);
 
    return var;
 }
@@ -373,6 +429,7 @@ EXPORT_FROM_DLL void ScriptVariableList::RemoveVariable(ScriptVariable *var)
    }
 
    list.RemoveObject(var);
+   map->erase(var);
 }
 
 EXPORT_FROM_DLL void ScriptVariableList::RemoveVariable(const char *name)
@@ -391,40 +448,17 @@ EXPORT_FROM_DLL void ScriptVariableList::RemoveVariable(const char *name)
 
 EXPORT_FROM_DLL qboolean ScriptVariableList::VariableExists(const char *name)
 {
-   int i;
-   int num;
-   ScriptVariable *var;
-
-   num = list.NumObjects();
-   for(i = 1; i <= num; i++)
-   {
-      var = list.ObjectAt(i);
-      if(!strcmp(var->getName(), name))
-      {
-         return true;
-      }
-   }
-
-   return false;
+   return GetVariable(name) != NULL;
 }
 
 EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::GetVariable(const char *name)
 {
-   int i;
-   int num;
-   ScriptVariable *var;
-
-   num = list.NumObjects();
-   for(i = 1; i <= num; i++)
+   if(!map)
    {
-      var = list.ObjectAt(i);
-      if(!strcmp(var->getName(), name))
-      {
-         return var;
-      }
+      return NULL;
    }
 
-   return NULL;
+   return map->find(name);
 }
 
 EXPORT_FROM_DLL int ScriptVariableList::NumVariables()
@@ -446,7 +480,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::SetVariable(const char *name
    {
       var = new ScriptVariable();
       var->setName(name);
-      list.AddObject(var);
+      InsertVariable(var);
    }
 
    var->setFloatValue(value);
@@ -463,7 +497,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::SetVariable(const char *name
    {
       var = new ScriptVariable();
       var->setName(name);
-      list.AddObject(var);
+      InsertVariable(var);
    }
 
    var->setIntValue(value);
@@ -480,7 +514,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::SetVariable(const char *name
    {
       var = new ScriptVariable();
       var->setName(name);
-      list.AddObject(var);
+      InsertVariable(var);
    }
 
    var->setStringValue(text);
@@ -497,7 +531,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::SetVariable(const char *name
    {
       var = new ScriptVariable();
       var->setName(name);
-      list.AddObject(var);
+      InsertVariable(var);
    }
 
    if(!ent)
@@ -522,7 +556,7 @@ EXPORT_FROM_DLL ScriptVariable *ScriptVariableList::SetVariable(const char *name
    {
       var = new ScriptVariable();
       var->setName(name);
-      list.AddObject(var);
+      InsertVariable(var);
    }
 
    var->setStringValue(va("(%f %f %f)", vec.x, vec.y, vec.z));
@@ -540,7 +574,7 @@ void ScriptVariable::Var_Append(Event *ev)
 {
    str newstring;
 
-   newstring = string + ev->GetString(1);
+   newstring = str(stringValue()) + ev->GetString(1);
    setStringValue(newstring.c_str());
 }
 
@@ -548,7 +582,7 @@ void ScriptVariable::Var_AppendInt(Event *ev)
 {
    str newstring;
 
-   newstring = string + va("%d", ev->GetInteger(1));
+   newstring = str(stringValue()) + va("%d", ev->GetInteger(1));
    setStringValue(newstring.c_str());
 }
 
@@ -556,7 +590,7 @@ void ScriptVariable::Var_AppendFloat(Event *ev)
 {
    str newstring;
 
-   newstring = string + va("%f", ev->GetFloat(1));
+   newstring = str(stringValue()) + va("%f", ev->GetFloat(1));
    setStringValue(newstring.c_str());
 }
 
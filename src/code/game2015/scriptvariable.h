@@ -66,15 +66,27 @@ extern Event EV_Var_GetTarget;
 extern Event EV_Var_GetWeapon;
 //###
 
+// What the text of a variable has to be built from when it's asked for
+typedef enum
+{
+   VAR_TEXT_VALID,
+   VAR_TEXT_INTEGER,
+   VAR_TEXT_FLOAT,
+   VAR_TEXT_VECTOR
+} vartext_t;
+
 class ScriptVariable : public Listener
 {
 private:
    str                  name;
-   float                value  = 0.0f;
+   float                value    = 0.0f;
+   int                  intvalue = 0;
    str                  string;
+   int                  textform = VAR_TEXT_VALID;
    Vector               vec;
 
    void                 setString(const char *newvalue);
+   void                 buildString();
 
 public:
    CLASS_PROTOTYPE(ScriptVariable);
@@ -154,23 +166,32 @@ inline void ScriptVariable::Archive(Archiver &arc)
 {
    arc.WriteString(name);
    arc.WriteFloat(value);
+   stringValue();
    arc.WriteString(string);
    arc.WriteVector(vec);
 }
 
 inline void ScriptVariable::Unarchive(Archiver &arc)
 {
-   name = arc.ReadString();
+   setName(arc.ReadString().c_str());
    value = arc.ReadFloat();
    string = arc.ReadString();
+   textform = VAR_TEXT_VALID;
    vec = arc.ReadVector();
 }
 
+class ScriptVariableMap;
+
 class ScriptVariableList : public Class
 {
 private:
    Container<ScriptVariable *> list;
 
+   // index of list by name
+   ScriptVariableMap          *map = nullptr;
+
+   void            InsertVariable(ScriptVariable *var);
+
 public:
    CLASS_PROTOTYPE(ScriptVariableList);
 
@@ -230,6 +251,7 @@ inline void ScriptVariableList::Unarchive(Archiver &arc)
 }
 
 typedef SafePtr<ScriptVariable> ScriptVariablePtr;
+typedef Handle<ScriptVariable> ScriptVariableHandle;
 
 #endif /* scriptvariable.h */
 
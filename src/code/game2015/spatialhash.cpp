@@ -0,0 +1,435 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Uniform grid of entity centroids for proximity queries.  Every entity is
+// filed under the SPATIAL_CELL_SIZE cube its centroid is in, and the cubes are
+// hashed into SPATIAL_NUM_BUCKETS lists so the grid covers any size of level.
+// Entity::link moves entities between cells when their centroid changes,
+// which is the only place the centroid is set.
+//
+
+#include "g_local.h"
+#include "entity.h"
+#include "spatialhash.h"
+
+// anything past this is off the map, and keeps the cell counts from overflowing
+#define SPATIAL_MAX_COORD 65536
+
+typedef struct
+{
+   int cell[3];
+   int bucket;    // -1 when not in the grid
+   int next;
+   int prev;
+} spatialnode_t;
+
+static spatialnode_t *spatialNodes;
+static int            spatialBuckets[SPATIAL_NUM_BUCKETS];
+static int           *spatialScratch;
+
+// bumped whenever an entity enters, leaves, or changes cells
+static unsigned       spatialGeneration;
+
+// candidates for the last findradius search
+static int           *spanList;
+static int            spanNum;
+static Vector         spanOrg;
+static float          spanRad;
+static unsigned       spanGeneration;
+static qboolean       spanValid;
+
+static inline int G_SpatialCoord(float v)
+{
+   return (int)floor(v / SPATIAL_CELL_SIZE);
+}
+
+static inline int G_SpatialBucket(int x, int y, int z)
+{
+   return ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u) & (SPATIAL_NUM_BUCKETS - 1);
+}
+
+/*
+===============
+G_InitSpatialHash
+
+Called from G_AllocGameData once the edicts have been allocated.  Any
+entities still around are forgotten, which is fine since they're about to be
+thrown out with the rest of the game data.
+===============
+*/
+EXPORT_FROM_DLL void G_InitSpatialHash(void)
+{
+   int i;
+
+   spatialNodes = (spatialnode_t *)gi.TagMalloc(game.maxentities * sizeof(spatialNodes[0]), TAG_GAME);
+   spatialScratch = (int *)gi.TagMalloc(game.maxentities * sizeof(spatialScratch[0]), TAG_GAME);
+   spanList = (int *)gi.TagMalloc(game.maxentities * sizeof(spanList[0]), TAG_GAME);
+
+   for(i = 0; i < game.maxentities; i++)
+   {
+      spatialNodes[i].bucket = -1;
+   }
+
+   for(i = 0; i < SPATIAL_NUM_BUCKETS; i++)
+   {
+      spatialBuckets[i] = -1;
+   }
+
+   spanNum = 0;
+   spanValid = false;
+   spatialGeneration++;
+}
+
+static void G_SpatialRemoveNode(int entnum)
+{
+   spatialnode_t *node;
+
+   node = &spatialNodes[entnum];
+   if(node->prev >= 0)
+   {
+      spatialNodes[node->prev].next = node->next;
+   }
+   else
+   {
+      spatialBuckets[node->bucket] = node->next;
+   }
+
+   if(node->next >= 0)
+   {
+      spatialNodes[node->next].prev = node->prev;
+   }
+
+   node->bucket = -1;
+   spatialGeneration++;
+}
+
+/*
+===============
+G_SpatialLink
+
+Files the entity under the cell its centroid is in.  Nothing changes if it
+hasn't left its old cell.
+===============
+*/
+EXPORT_FROM_DLL void G_SpatialLink(Entity *ent)
+{
+   spatialnode_t *node;
+   int            x;
+   int            y;
+   int            z;
+
+   if(!spatialNodes || (ent->entnum < 0) || (ent->entnum >= game.maxentities))
+   {
+      return;
+   }
+
+   x = G_SpatialCoord(ent->centroid.x);
+   y = G_SpatialCoord(ent->centroid.y);
+   z = G_SpatialCoord(ent->centroid.z);
+
+   node = &spatialNodes[ent->entnum];
+   if(node->bucket >= 0)
+   {
+      if((node->cell[0] == x) && (node->cell[1] == y) && (node->cell[2] == z))
+      {
+         return;
+      }
+      G_SpatialRemoveNode(ent->entnum);
+   }
+
+   node->cell[0] = x;
+   node->cell[1] = y;
+   node->cell[2] = z;
+   node->bucket = G_SpatialBucket(x, y, z);
+   node->prev = -1;
+   node->next = spatialBuckets[node->bucket];
+   if(node->next >= 0)
+   {
+      spatialNodes[node->next].prev = ent->entnum;
+   }
+   spatialBuckets[node->bucket] = ent->entnum;
+
+   spatialGeneration++;
+}
+
+EXPORT_FROM_DLL void G_SpatialUnlink(Entity *ent)
+{
+   if(!spatialNodes || (ent->entnum < 0) || (ent->entnum >= game.maxentities))
+   {
+      return;
+   }
+
+   if(spatialNodes[ent->entnum].bucket >= 0)
+   {
+      G_SpatialRemoveNode(ent->entnum);
+   }
+}
+
+EXPORT_FROM_DLL unsigned G_SpatialGeneration(void)
+{
+   return spatialGeneration;
+}
+
+/*
+===============
+G_SpatialCells
+
+Lists every entity filed under a cell that touches the box.  Returns -1 if
+the box covers more than SPATIAL_MAX_CELLS cells or there are more than
+maxlist entities in them.
+===============
+*/
+static int G_SpatialCells(Vector mins, Vector maxs, int *list, int maxlist)
+{
+   spatialnode_t *node;
+   int            lo[3];
+   int            hi[3];
+   int            x;
+   int            y;
+   int            z;
+   int            i;
+   int            num;
+
+   if(!spatialNodes)
+   {
+      return -1;
+   }
+
+   for(i = 0; i < 3; i++)
+   {
+      if((mins[i] < -SPATIAL_MAX_COORD) || (maxs[i] > SPATIAL_MAX_COORD))
+      {
+         return -1;
+      }
+      lo[i] = G_SpatialCoord(mins[i]);
+      hi[i] = G_SpatialCoord(maxs[i]);
+   }
+
+   if((hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1) > SPATIAL_MAX_CELLS)
+   {
+      return -1;
+   }
+
+   num = 0;
+   for(x = lo[0]; x <= hi[0]; x++)
+   {
+      for(y = lo[1]; y <= hi[1]; y++)
+      {
+         for(z = lo[2]; z <= hi[2]; z++)
+         {
+            // other cells can share the bucket, so check the cell of each one
+            for(i = spatialBuckets[G_SpatialBucket(x, y, z)]; i >= 0; i = node->next)
+            {
+               node = &spatialNodes[i];
+               if((node->cell[0] != x) || (node->cell[1] != y) || (node->cell[2] != z))
+               {
+                  continue;
+               }
+
+               if(num >= maxlist)
+               {
+                  return -1;
+               }
+               list[num++] = i;
+            }
+         }
+      }
+   }
+
+   return num;
+}
+
+/*
+===============
+G_SpatialBox
+
+Fills list with the entities whose centroids are inside the box.  Returns
+how many were found, or -1 if the caller should search some other way.
+===============
+*/
+EXPORT_FROM_DLL int G_SpatialBox(Vector mins, Vector maxs, int *list, int maxlist)
+{
+   Entity  *ent;
+   int      num;
+   int      count;
+   int      i;
+
+   num = G_SpatialCells(mins, maxs, spatialScratch, game.maxentities);
+   if(num < 0)
+   {
+      return -1;
+   }
+
+   count = 0;
+   for(i = 0; i < num; i++)
+   {
+      ent = g_edicts[spatialScratch[i]].entity;
+      if((ent->centroid.x < mins.x) || (ent->centroid.x > maxs.x) ||
+         (ent->centroid.y < mins.y) || (ent->centroid.y > maxs.y) ||
+         (ent->centroid.z < mins.z) || (ent->centroid.z > maxs.z))
+      {
+         continue;
+      }
+
+      if(count >= maxlist)
+      {
+         return -1;
+      }
+      list[count++] = spatialScratch[i];
+   }
+
+   return count;
+}
+
+/*
+===============
+G_SpatialRadius
+
+Fills list with the entities whose centroids are within rad of org.  Returns
+how many were found, or -1 if the caller should search some other way.
+===============
+*/
+EXPORT_FROM_DLL int G_SpatialRadius(Vector org, float rad, int *list, int maxlist)
+{
+   Vector   delta;
+   Vector   ext;
+   float    r2;
+   int      num;
+   int      count;
+   int      i;
+
+   ext = Vector(rad, rad, rad);
+   num = G_SpatialCells(org - ext, org + ext, spatialScratch, game.maxentities);
+   if(num < 0)
+   {
+      return -1;
+   }
+
+   r2 = rad * rad;
+   count = 0;
+   for(i = 0; i < num; i++)
+   {
+      delta = org - g_edicts[spatialScratch[i]].entity->centroid;
+      if((delta * delta) > r2)
+      {
+         continue;
+      }
+
+      if(count >= maxlist)
+      {
+         return -1;
+      }
+      list[count++] = spatialScratch[i];
+   }
+
+   return count;
+}
+
+/*
+===============
+G_SpatialNearest
+
+Fills list with up to k entities within maxdist of org, nearest first.
+Returns how many were found, or -1 if the caller should search some other
+way.
+===============
+*/
+EXPORT_FROM_DLL int G_SpatialNearest(Vector org, float maxdist, int *list, int k)
+{
+   Vector   delta;
+   Vector   ext;
+   float    best;
+   float    dist;
+   int      bestnum;
+   int      num;
+   int      i;
+   int      j;
+
+   ext = Vector(maxdist, maxdist, maxdist);
+   num = G_SpatialCells(org - ext, org + ext, spatialScratch, game.maxentities);
+   if(num < 0)
+   {
+      return -1;
+   }
+
+   // k is expected to be small, so just pick out the closest each time
+   for(i = 0; i < k; i++)
+   {
+      best = maxdist * maxdist;
+      bestnum = -1;
+      for(j = i; j < num; j++)
+      {
+         delta = org - g_edicts[spatialScratch[j]].entity->centroid;
+         dist = delta * delta;
+         if(dist <= best)
+         {
+            best = dist;
+            bestnum = j;
+         }
+      }
+
+      if(bestnum < 0)
+      {
+         break;
+      }
+
+      list[i] = spatialScratch[bestnum];
+      spatialScratch[bestnum] = spatialScratch[i];
+   }
+
+   return i;
+}
+
+static int G_SpatialCompareEntnum(const void *arg1, const void *arg2)
+{
+   return *(const int *)arg1 - *(const int *)arg2;
+}
+
+/*
+===============
+G_SpatialRadiusSpan
+
+Returns every entity that could be within rad of org, in entity number order,
+for findradius to step through.  The list isn't checked against the distance
+since the entities can move around within their cells between calls, but it's
+only rebuilt when the search or the grid changes, so the usual
+"while((ent = findradius(ent, org, rad)))" loop builds it once.  Returns false
+if the caller should walk all the edicts instead.
+===============
+*/
+EXPORT_FROM_DLL qboolean G_SpatialRadiusSpan(Vector org, float rad, const int **span, int *num)
+{
+   Vector ext;
+
+   if(!spanValid || (spanGeneration != spatialGeneration) || (spanRad != rad) || (spanOrg != org))
+   {
+      ext = Vector(rad, rad, rad);
+      spanNum = G_SpatialCells(org - ext, org + ext, spanList, game.maxentities);
+      if(spanNum > 1)
+      {
+         qsort(spanList, spanNum, sizeof(spanList[0]), G_SpatialCompareEntnum);
+      }
+
+      spanOrg = org;
+      spanRad = rad;
+      spanGeneration = spatialGeneration;
+      spanValid = true;
+   }
+
+   if(spanNum < 0)
+   {
+      return false;
+   }
+
+   *span = spanList;
+   *num = spanNum;
+
+   return true;
+}
+
+// EOF
@@ -0,0 +1,38 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Uniform grid of entity centroids for proximity queries.
+//
+
+#ifndef __SPATIALHASH_H__
+#define __SPATIALHASH_H__
+
+#include "g_local.h"
+
+#define SPATIAL_CELL_SIZE     256
+#define SPATIAL_NUM_BUCKETS   4096
+
+// queries that would look at more cells than this return -1 so that the
+// caller can fall back to walking every entity
+#define SPATIAL_MAX_CELLS     512
+
+class Entity;
+
+EXPORT_FROM_DLL void     G_InitSpatialHash(void);
+EXPORT_FROM_DLL void     G_SpatialLink(Entity *ent);
+EXPORT_FROM_DLL void     G_SpatialUnlink(Entity *ent);
+EXPORT_FROM_DLL unsigned G_SpatialGeneration(void);
+
+EXPORT_FROM_DLL int      G_SpatialBox(Vector mins, Vector maxs, int *list, int maxlist);
+EXPORT_FROM_DLL int      G_SpatialRadius(Vector org, float rad, int *list, int maxlist);
+EXPORT_FROM_DLL int      G_SpatialNearest(Vector org, float maxdist, int *list, int k);
+EXPORT_FROM_DLL qboolean G_SpatialRadiusSpan(Vector org, float rad, const int **span, int *num);
+
+#endif /* spatialhash.h */
+
+// EOF
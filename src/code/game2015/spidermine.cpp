@@ -371,7 +371,6 @@ qboolean SpiderMine::IsDroppable()
 void SpiderMine::SetOwner(Sentient *sent)
 {
    Detonator   *detonator;
-   int         num;
 
    assert(sent);
    if(!sent)
@@ -405,10 +404,9 @@ void SpiderMine::SetOwner(Sentient *sent)
 
    // Check the world for any spidermines in existence and 
    // if the player owns them, add them to the minelist.
-   num = 0;
-   while((num = G_FindClass(num, "Mine")) != 0)
+   for(Entity *ent : G_ClassEntities("Mine"))
    {
-      Mine *mine = static_cast<Mine *>(G_GetEntity(num));
+      Mine *mine = static_cast<Mine *>(ent);
 
       if(mine->IsOwner(sent))
       {
@@ -134,12 +134,10 @@ void ViewMaster::Prev(Event *ev)
 void ViewMaster::DeleteAll(Event *ev)
 {
    Viewthing *viewthing;
-   int next;
 
-   next = 0;
-   while(next = G_FindClass(next, "viewthing"))
+   for(Entity *ent : G_ClassEntities("viewthing"))
    {
-      viewthing = (Viewthing *)G_GetEntity(next);
+      viewthing = (Viewthing *)ent;
       viewthing->PostEvent(EV_Remove, 0);
    }
 
@@ -29,6 +29,7 @@
 //###
 #include "spritegun.h"   // added for spritegun
 #include "checkpoints.h"
+#include "../elib/qstringmap.h"
 //###
 
 extern void CreateMissionComputer();
@@ -291,21 +292,59 @@ World::World() : Entity()
    level.earthquake = 0;
 }
 
-TargetList *World::GetTargetList(str &targetname)
+// fast lookup of target lists by targetname
+static auto targetKeyFunc = [] (TargetList *p) { return p->targetname.c_str(); };
+class TargetListMap : public qstringmap<TargetList *, decltype(targetKeyFunc)>
+{
+public:
+   using qstringmap::qstringmap;
+};
+
+/*
+====================
+World::FindTargetList
+
+Returns the list of entities with the targetname, or NULL if there's never
+been one.
+====================
+*/
+TargetList *World::FindTargetList(const char *targetname)
+{
+   if(!targetMap)
+   {
+      return nullptr;
+   }
+
+   return targetMap->find(targetname);
+}
+
+TargetList *World::GetTargetList(const char *targetname)
 {
    TargetList *targetlist;
 
-   for(int i = 1; i <= targetList.NumObjects(); i++)
+   targetlist = FindTargetList(targetname);
+   if(targetlist)
    {
-      targetlist = targetList.ObjectAt(i);
-      if(targetname == targetlist->targetname)
-         return targetlist;
+      return targetlist;
    }
+
+   if(!targetMap)
+   {
+      targetMap = new TargetListMap(targetKeyFunc);
+   }
+
    targetlist = new TargetList(targetname);
    targetList.AddObject(targetlist);
+   targetMap->insert(targetlist);
+
    return targetlist;
 }
 
+TargetList *World::GetTargetList(str &targetname)
+{
+   return GetTargetList(targetname.c_str());
+}
+
 void World::AddTargetEntity(str &targetname, Entity * ent)
 {
    TargetList * targetlist;
@@ -318,23 +357,35 @@ void World::RemoveTargetEntity(str &targetname, Entity * ent)
 {
    TargetList * targetlist;
 
-   targetlist = GetTargetList(targetname);
-   targetlist->RemoveEntity(ent);
+   targetlist = FindTargetList(targetname.c_str());
+   if(targetlist)
+   {
+      targetlist->RemoveEntity(ent);
+   }
 }
 
 Entity * World::GetNextEntity(str &targetname, Entity * ent)
 {
    TargetList * targetlist;
 
-   targetlist = GetTargetList(targetname);
+   targetlist = FindTargetList(targetname.c_str());
+   if(!targetlist)
+   {
+      return nullptr;
+   }
+
    return targetlist->GetNextEntity(ent);
 }
 
 //### added so I can trigger stuff easily from code
 void World::ActivateTarget(str &targetname)
 {
-   TargetList *targetlist = GetTargetList(targetname);
-   
+   TargetList *targetlist = FindTargetList(targetname.c_str());
+   if(!targetlist)
+   {
+      return;
+   }
+
    int num = targetlist->list.NumObjects();
    for(int i = 1; i <= num; i++)
    {
@@ -366,6 +417,9 @@ void World::FreeTargetList()
    }
 
    targetList.FreeObjectList();
+
+   delete targetMap;
+   targetMap = nullptr;
 }
 
 //
@@ -384,33 +438,128 @@ TargetList::TargetList(str &tname)
    targetname = tname;
 }
 
+TargetList::TargetList(const char *tname)
+{
+   targetname = tname;
+}
+
 TargetList::~TargetList()
 {
+   int i;
+   int j;
+   int num;
+   Entity *ent;
+
+   // don't leave the entities pointing at us
+   num = list.NumObjects();
+   for(i = 1; i <= num; i++)
+   {
+      ent = list.ObjectAt(i);
+      for(j = 0; j < 2; j++)
+      {
+         if(ent->targetlists[j] == this)
+         {
+            ent->targetlists[j] = nullptr;
+         }
+      }
+   }
+}
+
+//
+// Each entity remembers its index in the lists it's in, so adding, removing
+// and stepping to the next entity never have to search the list.  Removing
+// moves the last entity into the hole, so the order isn't kept.
+//
+
+static int TargetSlot(Entity *ent, TargetList *targetlist)
+{
+   if(ent->targetlists[0] == targetlist)
+   {
+      return 0;
+   }
+   else if(ent->targetlists[1] == targetlist)
+   {
+      return 1;
+   }
+
+   return -1;
 }
 
 void TargetList::AddEntity(Entity * ent)
 {
-   if(!list.ObjectInList(ent))
+   int slot;
+
+   if(TargetSlot(ent, this) != -1)
+   {
+      return;
+   }
+
+   slot = TargetSlot(ent, nullptr);
+   if(slot == -1)
    {
-      list.AddObject(ent);
+      // an entity only has two targetnames, so this shouldn't happen
+      assert(0);
+      if(!list.ObjectInList(ent))
+      {
+         list.AddObject(ent);
+      }
+      return;
    }
+
+   ent->targetlists[slot] = this;
+   ent->targetindex[slot] = list.AddObject(ent);
 }
 
 void TargetList::RemoveEntity(Entity * ent)
 {
-   if(list.ObjectInList(ent))
+   Entity *last;
+   int     slot;
+   int     index;
+   int     num;
+
+   slot = TargetSlot(ent, this);
+   if(slot == -1)
    {
-      list.RemoveObject(ent);
+      if(list.ObjectInList(ent))
+      {
+         list.RemoveObject(ent);
+      }
+      return;
    }
+
+   index = ent->targetindex[slot];
+   ent->targetlists[slot] = nullptr;
+   ent->targetindex[slot] = 0;
+
+   num = list.NumObjects();
+   if(index != num)
+   {
+      last = list.ObjectAt(num);
+      list.SetObjectAt(index, last);
+      last->targetindex[TargetSlot(last, this)] = index;
+   }
+   list.RemoveObjectAt(num);
 }
 
 Entity *TargetList::GetNextEntity(Entity * ent)
 {
    int index;
+   int slot;
 
    index = 0;
    if(ent)
-      index = list.IndexOfObject(ent);
+   {
+      slot = TargetSlot(ent, this);
+      if(slot != -1)
+      {
+         index = ent->targetindex[slot];
+      }
+      else
+      {
+         index = list.IndexOfObject(ent);
+      }
+   }
+
    index++;
    if(index > list.NumObjects())
       return nullptr;
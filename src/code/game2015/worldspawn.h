@@ -35,6 +35,7 @@ public:
 
    TargetList() = default;
    TargetList(str &tname);
+   TargetList(const char *tname);
    ~TargetList();
    void      AddEntity(Entity * ent);
    void      RemoveEntity(Entity * ent);
@@ -45,11 +46,16 @@ public:
 template class EXPORT_FROM_DLL Container<TargetList *>;
 #endif
 
+class TargetListMap;
+
 class EXPORT_FROM_DLL World : public Entity
 {
 private:
    Container<TargetList *> targetList;
 
+   // index of targetList by targetname
+   TargetListMap          *targetMap = nullptr;
+
 public:
    CLASS_PROTOTYPE(World);
 
@@ -60,6 +66,8 @@ public:
 
    void        FreeTargetList();
    TargetList *GetTargetList(str &targetname);
+   TargetList *GetTargetList(const char *targetname);
+   TargetList *FindTargetList(const char *targetname);
    void        AddTargetEntity(str &targetname, Entity * ent);
    void        RemoveTargetEntity(str &targetname, Entity * ent);
    Entity     *GetNextEntity(str &targetname, Entity * ent);
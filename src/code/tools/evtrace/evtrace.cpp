@@ -0,0 +1,310 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2020 by Night Dive Studios, Inc.
+// All rights reserved.
+//
+// See the license.txt file for conditions and terms of use for this code.
+//
+// DESCRIPTION:
+// Decoder for the binary event traces written by "sv eventtrace".
+//
+//   evtrace [-chrome] tracefile [outfile]
+//
+// Without -chrome the trace is printed in the same format as g_showevents,
+// except that arguments are shown as a count and digest.  With -chrome it's
+// written as Chrome trace event JSON for chrome://tracing or Perfetto.
+//
+// Build with any C++ compiler, e.g. "cl /EHsc evtrace.cpp" or
+// "g++ -O2 -o evtrace evtrace.cpp".
+// 
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "../../game2015/evtracefile.h"
+
+// matches eventsource_t in listener.h
+enum
+{
+   EV_FROM_CODE,
+   EV_FROM_CONSOLE,
+   EV_FROM_SCRIPT
+};
+
+static std::vector<std::string> strings;
+static std::vector<std::string> eventnames;
+
+static const std::string &Lookup(std::vector<std::string> &list, int num)
+{
+   static const std::string unknown = "?";
+
+   if((num < 0) || (num >= (int)list.size()))
+   {
+      return unknown;
+   }
+
+   return list[num];
+}
+
+static void Define(std::vector<std::string> &list, int num, const std::string &text)
+{
+   if(num < 0)
+   {
+      return;
+   }
+
+   if(num >= (int)list.size())
+   {
+      list.resize(num + 1);
+   }
+
+   list[num] = text;
+}
+
+static bool ReadName(FILE *f, const evtrecord_t &rec, std::string &text)
+{
+   evtrecord_t data;
+   int         len;
+   int         i;
+
+   len = rec.numargs;
+   text.clear();
+   for(i = 0; i < len; i += sizeof(evtrecord_t))
+   {
+      if(fread(&data, sizeof(data), 1, f) != 1)
+      {
+         return false;
+      }
+
+      text.append((const char *)&data, ((len - i) < (int)sizeof(data)) ? (len - i) : sizeof(data));
+   }
+
+   return true;
+}
+
+static std::string JSONString(const std::string &text)
+{
+   std::string out;
+   char        hex[8];
+   size_t      i;
+
+   out = "\"";
+   for(i = 0; i < text.size(); i++)
+   {
+      unsigned char c = (unsigned char)text[i];
+
+      if((c == '"') || (c == '\\'))
+      {
+         out += '\\';
+         out += c;
+      }
+      else if(c < 0x20)
+      {
+         snprintf(hex, sizeof(hex), "\\u%04x", c);
+         out += hex;
+      }
+      else
+      {
+         out += c;
+      }
+   }
+   out += "\"";
+
+   return out;
+}
+
+static void PrintText(FILE *out, const evtrecord_t &rec)
+{
+   fprintf(out, "%.1f: %s", rec.time, Lookup(strings, rec.classname).c_str());
+
+   switch(rec.object)
+   {
+   case EVTOBJ_ENTITY:
+      fprintf(out, " (*%d) ", rec.entnum);
+      if(rec.label)
+      {
+         fprintf(out, "'%s'", Lookup(strings, rec.label).c_str());
+      }
+      break;
+
+   case EVTOBJ_THREAD:
+      fprintf(out, " #%d:'%s'", rec.threadnum, Lookup(strings, rec.label).c_str());
+      break;
+
+   case EVTOBJ_VARIABLE:
+      fprintf(out, " '%s'", Lookup(strings, rec.label).c_str());
+      break;
+   }
+
+   switch(rec.source)
+   {
+   default:
+   case EV_FROM_CODE:
+      fprintf(out, " : Code :");
+      break;
+
+   case EV_FROM_SCRIPT:
+      fprintf(out, " : %s(%d) :", Lookup(strings, rec.filename).c_str(), rec.linenumber);
+      break;
+
+   case EV_FROM_CONSOLE:
+      fprintf(out, " : Console :");
+      break;
+   }
+
+   fprintf(out, "%s", Lookup(eventnames, rec.eventnum).c_str());
+   if(rec.numargs)
+   {
+      fprintf(out, " <%d args %08x>", rec.numargs, rec.argdigest);
+   }
+   fprintf(out, "\n");
+}
+
+static void PrintChrome(FILE *out, const evtrecord_t &rec, bool first)
+{
+   std::string where;
+
+   switch(rec.source)
+   {
+   default:
+   case EV_FROM_CODE:
+      where = "code";
+      break;
+
+   case EV_FROM_SCRIPT:
+      where = Lookup(strings, rec.filename) + "(" + std::to_string(rec.linenumber) + ")";
+      break;
+
+   case EV_FROM_CONSOLE:
+      where = "console";
+      break;
+   }
+
+   // one row per entity, everything else shares row 0
+   fprintf(out, "%s{\"name\":%s,\"cat\":%s,\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"frame\":%d,\"time\":%.1f,\"label\":%s,\"source\":%s,\"numargs\":%d,\"digest\":\"%08x\"}}",
+           first ? "\n" : ",\n", JSONString(Lookup(eventnames, rec.eventnum)).c_str(),
+           JSONString(Lookup(strings, rec.classname)).c_str(), (double)rec.timestamp / 1000.0,
+           (rec.entnum >= 0) ? rec.entnum : 0, rec.framenum, rec.time, JSONString(Lookup(strings, rec.label)).c_str(),
+           JSONString(where).c_str(), rec.numargs, rec.argdigest);
+}
+
+int main(int argc, char **argv)
+{
+   evtraceheader_t header;
+   evtrecord_t     rec;
+   std::string     text;
+   FILE           *f;
+   FILE           *out;
+   bool            chrome;
+   bool            first;
+   int             arg;
+   int             count;
+
+   chrome = false;
+   arg = 1;
+   if((argc > arg) && !strcmp(argv[arg], "-chrome"))
+   {
+      chrome = true;
+      arg++;
+   }
+
+   if((argc - arg < 1) || (argc - arg > 2))
+   {
+      fprintf(stderr, "usage: evtrace [-chrome] tracefile [outfile]\n");
+      return 1;
+   }
+
+   f = fopen(argv[arg], "rb");
+   if(!f)
+   {
+      fprintf(stderr, "Couldn't open %s\n", argv[arg]);
+      return 1;
+   }
+
+   if((fread(&header, sizeof(header), 1, f) != 1) || (header.ident != EVTRACE_IDENT))
+   {
+      fprintf(stderr, "%s is not an event trace\n", argv[arg]);
+      fclose(f);
+      return 1;
+   }
+
+   if((header.version != EVTRACE_VERSION) || (header.recordsize != (int)sizeof(evtrecord_t)))
+   {
+      fprintf(stderr, "%s is version %d, expected version %d\n", argv[arg], header.version, EVTRACE_VERSION);
+      fclose(f);
+      return 1;
+   }
+
+   out = stdout;
+   if(argc - arg == 2)
+   {
+      out = fopen(argv[arg + 1], "wt");
+      if(!out)
+      {
+         fprintf(stderr, "Couldn't open %s\n", argv[arg + 1]);
+         fclose(f);
+         return 1;
+      }
+   }
+
+   strings.push_back("");
+
+   if(chrome)
+   {
+      fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+   }
+
+   first = true;
+   count = 0;
+   while(fread(&rec, sizeof(rec), 1, f) == 1)
+   {
+      switch(rec.type)
+      {
+      case EVTREC_STRING:
+      case EVTREC_EVENTNAME:
+         if(!ReadName(f, rec, text))
+         {
+            fprintf(stderr, "Trace ends in the middle of a string\n");
+            break;
+         }
+         Define((rec.type == EVTREC_STRING) ? strings : eventnames, rec.eventnum, text);
+         break;
+
+      case EVTREC_EVENT:
+         if(chrome)
+         {
+            PrintChrome(out, rec, first);
+         }
+         else
+         {
+            PrintText(out, rec);
+         }
+         first = false;
+         count++;
+         break;
+
+      default:
+         fprintf(stderr, "Unknown record type %d\n", rec.type);
+         break;
+      }
+   }
+
+   if(chrome)
+   {
+      fprintf(out, "\n]}\n");
+   }
+
+   fclose(f);
+   if(out != stdout)
+   {
+      fclose(out);
+   }
+
+   fprintf(stderr, "%d events\n", count);
+
+   return 0;
+}
+
+// EOF